@@ -0,0 +1,446 @@
+// Benchmark suite for the URL editor.
+//
+// Runs the real UrlEditorWindow against an in-process mock HTTP server so
+// fetch-path changes can be measured without touching the network. Each
+// scenario prints one JSON object per line (JSON Lines) for regression
+// tracking.
+//
+//   urleditor-bench [--sizes=1000,10000,100000] [--enrich-max=10000]
+//                   [--latency=ms] [--page-size=bytes] [--redirects=n]
+//                   [--fail=percent] [--timeout=percent] [--output=file]
+//
+// Needs a display (run under xvfb-run on headless machines).
+
+#define URL_EDITOR_NO_MAIN
+#include "url-editor.cpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+// 16x16 opaque PNG served for every favicon request
+const unsigned char mock_favicon_png[] = {
+    0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x10, 0x08, 0x06, 0x00, 0x00, 0x00, 0x1f, 0xf3, 0xff,
+    0x61, 0x00, 0x00, 0x00, 0x19, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x63, 0x30, 0x4e, 0x3b, 0xf3,
+    0x9f, 0x12, 0xcc, 0x30, 0x6a, 0xc0, 0xa8, 0x01, 0xa3, 0x06, 0x0c, 0x17, 0x03, 0x00, 0x07, 0xd6,
+    0x64, 0x1f, 0x47, 0x17, 0xd8, 0x12, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42,
+    0x60, 0x82
+};
+
+struct MockServerConfig {
+    int latency_ms = 0;        // Delay before every response
+    size_t page_size = 4096;   // Size of HTML pages, padded with a comment
+    int redirects = 0;         // 302 hops before a page is served
+    int failure_percent = 0;   // Hosts answering 500 to everything
+    int timeout_percent = 0;   // Hosts that never answer within the client timeout
+};
+
+// Minimal HTTP/1.1 server on 127.0.0.1, one thread per connection.
+// Hosts are named hN.localhost (curl resolves *.localhost to loopback), so
+// every row has its own host and favicons are not shared between rows.
+// Failures and timeouts are chosen by N, which keeps runs reproducible.
+class MockHttpServer {
+public:
+    ~MockHttpServer() { stop(); }
+
+    bool start() {
+        listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (listen_fd < 0) return false;
+
+        int reuse = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        socklen_t length = sizeof(address);
+        if (bind(listen_fd, (sockaddr*)&address, sizeof(address)) < 0 ||
+            listen(listen_fd, 512) < 0 ||
+            getsockname(listen_fd, (sockaddr*)&address, &length) < 0) {
+            close(listen_fd);
+            listen_fd = -1;
+            return false;
+        }
+        listen_port = ntohs(address.sin_port);
+
+        running = true;
+        accept_thread = std::thread([this]() { accept_loop(); });
+        return true;
+    }
+
+    void stop() {
+        if (!running) return;
+        running = false;
+        shutdown(listen_fd, SHUT_RDWR);
+        close(listen_fd);
+        accept_thread.join();
+    }
+
+    int port() const { return listen_port; }
+    long request_count() const { return requests; }
+
+    // Only change between scenarios, while no requests are in flight
+    MockServerConfig config;
+
+private:
+    void accept_loop() {
+        while (running) {
+            int client_fd = accept(listen_fd, nullptr, nullptr);
+            if (client_fd < 0) {
+                if (!running) break;
+                continue;
+            }
+            std::thread([this, client_fd]() {
+                handle(client_fd);
+                close(client_fd);
+            }).detach();
+        }
+    }
+
+    void handle(int client_fd) {
+        std::string request;
+        char buffer[4096];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < 65536) {
+            ssize_t received = recv(client_fd, buffer, sizeof(buffer), 0);
+            if (received <= 0) return;
+            request.append(buffer, received);
+        }
+        requests++;
+
+        // "GET /path HTTP/1.1"
+        size_t path_start = request.find(' ');
+        size_t path_end = request.find(' ', path_start + 1);
+        if (path_start == std::string::npos || path_end == std::string::npos) return;
+        std::string path = request.substr(path_start + 1, path_end - path_start - 1);
+
+        // hN.localhost:port -> N
+        long host_index = -1;
+        size_t host_pos = request.find("\r\nHost: h");
+        if (host_pos != std::string::npos) {
+            host_index = std::strtol(request.c_str() + host_pos + 9, nullptr, 10);
+        }
+
+        if (host_index >= 0 && host_index % 100 < config.timeout_percent) {
+            // Hold the connection open past the client's timeout
+            for (int i = 0; i < 120 && running; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            return;
+        }
+
+        if (config.latency_ms > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(config.latency_ms));
+        }
+
+        if (host_index >= 0 && host_index % 100 < config.timeout_percent + config.failure_percent) {
+            respond(client_fd, "500 Internal Server Error", "text/plain", "error");
+            return;
+        }
+
+        if (path.compare(0, 12, "/favicon.ico") == 0 || path.compare(0, 12, "/favicon.png") == 0 ||
+            path.compare(0, 12, "/s2/favicons") == 0) {
+            respond(client_fd, "200 OK", "image/png",
+                    std::string((const char*)mock_favicon_png, sizeof(mock_favicon_png)));
+            return;
+        }
+
+        // Pages redirect to themselves with ?hop=N until enough hops were made
+        int hop = 0;
+        size_t hop_pos = path.find("?hop=");
+        if (hop_pos != std::string::npos) {
+            hop = std::atoi(path.c_str() + hop_pos + 5);
+            path.erase(hop_pos);
+        }
+        if (hop < config.redirects) {
+            respond(client_fd, "302 Found", "text/plain", "",
+                    "Location: " + path + "?hop=" + std::to_string(hop + 1) + "\r\n");
+            return;
+        }
+
+        std::string body = "<html><head><title>Mock page " + path + "</title></head><body>";
+        if (body.size() + 21 < config.page_size) {
+            body += "<!--" + std::string(config.page_size - body.size() - 21, 'x') + "-->";
+        }
+        body += "</body></html>";
+        respond(client_fd, "200 OK", "text/html; charset=utf-8", body);
+    }
+
+    static void respond(int client_fd, const std::string& status, const std::string& content_type,
+                        const std::string& body, const std::string& extra_headers = "") {
+        std::string response = "HTTP/1.1 " + status + "\r\n"
+                               "Content-Type: " + content_type + "\r\n"
+                               "Content-Length: " + std::to_string(body.size()) + "\r\n" +
+                               extra_headers +
+                               "Connection: close\r\n\r\n" + body;
+        size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t written = send(client_fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (written <= 0) return;
+            sent += written;
+        }
+    }
+
+    int listen_fd = -1;
+    int listen_port = 0;
+    std::atomic<bool> running{false};
+    std::atomic<long> requests{0};
+    std::thread accept_thread;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Reads a "VmRSS:" style field from /proc/self/status, in kB
+long proc_status_kb(const char* field) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    size_t field_length = std::strlen(field);
+    while (std::getline(status, line)) {
+        if (line.compare(0, field_length, field) == 0) {
+            return std::atol(line.c_str() + field_length);
+        }
+    }
+    return -1;
+}
+
+// Resets the peak RSS (VmHWM) so each scenario reports its own peak
+void reset_peak_rss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+}
+
+std::string make_url_list(size_t count, int port) {
+    std::string text;
+    text.reserve(count * 48);
+    for (size_t i = 0; i < count; ++i) {
+        text += "http://h" + std::to_string(i) + ".localhost:" + std::to_string(port) + "/page/" + std::to_string(i) + "\n";
+    }
+    return text;
+}
+
+// Runs the main loop until the window has nothing left to fetch
+bool wait_for_fetches(UrlEditorWindow& window, double timeout_seconds) {
+    Glib::RefPtr<Glib::MainContext> context = Glib::MainContext::get_default();
+    Clock::time_point start = Clock::now();
+    while (window.fetch_in_progress()) {
+        context->iteration(true);
+        if (seconds_since(start) > timeout_seconds) return false;
+    }
+    return true;
+}
+
+// Writes a saved session like the one a window leaves behind: every row
+// fetched, each host with its own icon
+void write_session(const std::string& path, size_t count, int port) {
+    std::vector<SessionEntry> entries(count);
+    std::vector<std::pair<std::string, std::string>> icons;
+    icons.reserve(count);
+    std::string png((const char*)mock_favicon_png, sizeof(mock_favicon_png));
+    for (size_t i = 0; i < count; ++i) {
+        std::string host = "http://h" + std::to_string(i) + ".localhost:" + std::to_string(port);
+        entries[i].url = host + "/page/" + std::to_string(i);
+        entries[i].title = "Mock page /page/" + std::to_string(i);
+        entries[i].icon_key = host;
+        entries[i].status = FETCH_DONE;
+        icons.push_back(std::make_pair(host, png));
+    }
+    SessionStore store(path);
+    store.save(1, entries, icons);
+}
+
+// Runs the main loop until the window has built every saved row
+bool wait_for_restore(UrlEditorWindow& window, double timeout_seconds) {
+    Glib::RefPtr<Glib::MainContext> context = Glib::MainContext::get_default();
+    Clock::time_point start = Clock::now();
+    while (window.restore_in_progress()) {
+        context->iteration(true);
+        if (seconds_since(start) > timeout_seconds) return false;
+    }
+    return true;
+}
+
+void drain_main_loop() {
+    Glib::RefPtr<Glib::MainContext> context = Glib::MainContext::get_default();
+    while (context->pending()) {
+        context->iteration(false);
+    }
+}
+
+class Report {
+public:
+    explicit Report(std::ostream& out) : out(out) {}
+
+    void emit(const std::string& scenario, size_t entries, double seconds,
+              const std::string& extra = "") {
+        out << "{\"scenario\":\"" << scenario << "\""
+            << ",\"entries\":" << entries
+            << ",\"seconds\":" << seconds
+            << ",\"entries_per_second\":" << (seconds > 0 ? entries / seconds : 0)
+            << ",\"rss_kb\":" << proc_status_kb("VmRSS:")
+            << ",\"peak_rss_kb\":" << proc_status_kb("VmHWM:")
+            << extra << "}" << std::endl;
+    }
+
+private:
+    std::ostream& out;
+};
+
+std::vector<size_t> parse_sizes(const std::string& list) {
+    std::vector<size_t> sizes;
+    std::istringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            sizes.push_back(std::strtoul(item.c_str(), nullptr, 10));
+        }
+    }
+    return sizes;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> sizes = {1000, 10000, 100000};
+    size_t enrich_max = 10000;
+    std::string output_path;
+    MockHttpServer server;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&arg]() { return arg.substr(arg.find('=') + 1); };
+        if (arg.compare(0, 8, "--sizes=") == 0) {
+            sizes = parse_sizes(value());
+        } else if (arg.compare(0, 13, "--enrich-max=") == 0) {
+            enrich_max = std::strtoul(value().c_str(), nullptr, 10);
+        } else if (arg.compare(0, 10, "--latency=") == 0) {
+            server.config.latency_ms = std::atoi(value().c_str());
+        } else if (arg.compare(0, 12, "--page-size=") == 0) {
+            server.config.page_size = std::strtoul(value().c_str(), nullptr, 10);
+        } else if (arg.compare(0, 12, "--redirects=") == 0) {
+            server.config.redirects = std::atoi(value().c_str());
+        } else if (arg.compare(0, 7, "--fail=") == 0) {
+            server.config.failure_percent = std::atoi(value().c_str());
+        } else if (arg.compare(0, 10, "--timeout=") == 0) {
+            server.config.timeout_percent = std::atoi(value().c_str());
+        } else if (arg.compare(0, 9, "--output=") == 0) {
+            output_path = value();
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    if (!server.start()) {
+        std::cerr << "Failed to start mock HTTP server" << std::endl;
+        return 1;
+    }
+
+    std::ofstream output_file;
+    if (!output_path.empty()) {
+        output_file.open(output_path);
+    }
+    Report report(output_path.empty() ? std::cout : output_file);
+
+    // Restored windows open the session and the title cache; both go to a
+    // scratch directory, never the user's
+    gchar* data_dir = g_dir_make_tmp("urleditor-bench-XXXXXX", nullptr);
+    if (!data_dir) {
+        std::cerr << "Failed to create a data directory" << std::endl;
+        return 1;
+    }
+    g_setenv("XDG_DATA_HOME", data_dir, TRUE);
+    g_setenv("XDG_CACHE_HOME", data_dir, TRUE);
+    std::string session_dir = Glib::build_filename(data_dir, "url-editor");
+    g_mkdir_with_parents(session_dir.c_str(), 0700);
+    std::string session_path = Glib::build_filename(session_dir, "session.db");
+    g_free(data_dir);
+
+    // Gtk::Application::create() initializes GTK; the app itself is never run
+    int gtk_argc = 1;
+    auto app = Gtk::Application::create(gtk_argc, argv, "com.stelijah.url-editor.bench",
+                                        Gio::APPLICATION_NON_UNIQUE);
+    Tracer::instance().start_from_environment();
+    UrlEditorWindow window(false);
+    window.set_favicon_service("http://127.0.0.1:" + std::to_string(server.port()) + "/s2/favicons?domain=");
+    window.show();
+    drain_main_loop();
+
+    for (size_t size : sizes) {
+        std::string text = make_url_list(size, server.port());
+
+        // Text parsing alone
+        reset_peak_rss();
+        Clock::time_point start = Clock::now();
+        std::vector<UrlEntry> parsed = parse_url_text(text, true);
+        double parse_seconds = seconds_since(start);
+        report.emit("parse", parsed.size(), parse_seconds,
+                    ",\"mb_per_second\":" + std::to_string(text.size() / 1e6 / parse_seconds));
+        parsed.clear();
+        parsed.shrink_to_fit();
+
+        // Parse, diff and build the rows, until the window is drawn
+        reset_peak_rss();
+        long requests_before = server.request_count();
+        start = Clock::now();
+        window.load_text(text);
+        drain_main_loop();
+        EntryStore::MemoryUsage usage = window.entry_memory_usage();
+        report.emit("populate", size, seconds_since(start),
+                    ",\"store_bytes\":" + std::to_string(usage.total_bytes()) +
+                    ",\"store_bytes_per_entry\":" + std::to_string(usage.bytes_per_entry()));
+
+        // Favicons and titles for every row
+        if (size <= enrich_max) {
+            bool finished = wait_for_fetches(window, 600);
+            report.emit("enrich", size, seconds_since(start),
+                        ",\"finished\":" + std::string(finished ? "true" : "false") +
+                        ",\"requests\":" + std::to_string(server.request_count() - requests_before) +
+                        ",\"latency_ms\":" + std::to_string(server.config.latency_ms) +
+                        ",\"fail_percent\":" + std::to_string(server.config.failure_percent) +
+                        ",\"timeout_percent\":" + std::to_string(server.config.timeout_percent));
+        }
+
+        // A saved session of the same size: the rows built before the
+        // window is shown, then the whole list
+        write_session(session_path, size, server.port());
+        reset_peak_rss();
+        start = Clock::now();
+        {
+            UrlEditorWindow restored(true);
+            double first_rows_seconds = seconds_since(start);
+            restored.show();
+            bool finished = wait_for_restore(restored, 600);
+            drain_main_loop();
+            report.emit("restore", size, seconds_since(start),
+                        ",\"first_rows_seconds\":" + std::to_string(first_rows_seconds) +
+                        ",\"finished\":" + std::string(finished ? "true" : "false"));
+            restored.hide();
+        }
+        drain_main_loop();
+
+        // Empty the list for the next size
+        window.load_text("");
+        wait_for_fetches(window, 60);
+        drain_main_loop();
+    }
+
+    window.hide();
+    server.stop();
+    Tracer::instance().stop();
+    return 0;
+}
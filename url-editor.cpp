@@ -5,6 +5,7 @@
 #include <gtkmm/button.h>
 #include <gtkmm/radiobutton.h>
 #include <gtkmm/radiobuttongroup.h>
+#include <gtkmm/checkbutton.h>
 #include <gtkmm/label.h>
 #include <gtkmm/entry.h>
 #include <gtkmm/textview.h>
@@ -20,868 +21,6093 @@
 #include <gtkmm/clipboard.h>
 #include <gtkmm/cssprovider.h>
 #include <gtkmm/stylecontext.h>
+#include <gtkmm/filechooserdialog.h>
+#include <gtkmm/comboboxtext.h>
+#include <gtkmm/paned.h>
+#include <gtkmm/treeview.h>
+#include <gtkmm/liststore.h>
+#include <gtkmm/treestore.h>
+#include <gtkmm/dialog.h>
+#include <gtkmm/cellrenderertoggle.h>
 #include <glibmm/ustring.h>
 #include <glibmm/fileutils.h>
 #include <glibmm/convert.h>
 #include <glibmm/main.h>
 #include <glibmm/iochannel.h>
 #include <glibmm/markup.h>
+#include <glibmm/miscutils.h>
+#include <glibmm/keyfile.h>
+#include <giomm/file.h>
+#include <giomm/filemonitor.h>
+#include <giomm/applicationcommandline.h>
+#include <giomm/inputstream.h>
+#include <sigc++/adaptors/track_obj.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gdk/gdk.h>
 #include <glib.h>
 #include <curl/curl.h>
+#include <sqlite3.h>
+#include <zstd.h>
 #include <vector>
+#include <deque>
 #include <memory>
 #include <thread>
+#include <chrono>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <regex>
-
-struct UrlEntry {
-    Glib::ustring title;
-    Glib::ustring url;
-
-    UrlEntry(const Glib::ustring& t, const Glib::ustring& u) : title(t), url(u) {}
-};
-
-// Custom row widget for list items
-class UrlRow : public Gtk::Box {
+#include <functional>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <cstring>
+#include <set>
+#include <algorithm>
+#include <unordered_map>
+#include <string_view>
+#include <cstdint>
+#include <sys/stat.h>
+#include <unordered_set>
+
+// Writes Chrome trace-event JSON (load it in chrome://tracing or Perfetto)
+// when started with --trace=<file> or URL_EDITOR_TRACE=<file>. Spans become
+// complete ("X") events on the thread that ran them. While tracing, a
+// heartbeat on the main loop reports every iteration longer than 16 ms,
+// naming the longest main-thread span that ran during it.
+class Tracer {
 public:
-    UrlRow(const Glib::ustring& title, const Glib::ustring& url)
-        : Gtk::Box(Gtk::ORIENTATION_HORIZONTAL, 10), title_text(title), url_text(url) {
-        set_margin_start(5);
-        set_margin_end(5);
-        set_margin_top(5);
-        set_margin_bottom(5);
+    static Tracer& instance() {
+        static Tracer tracer;
+        return tracer;
+    }
 
-        // Create number label
-        number_label = Gtk::manage(new Gtk::Label("0"));
-        number_label->set_halign(Gtk::ALIGN_START);
-        number_label->set_valign(Gtk::ALIGN_START);
-        number_label->set_width_chars(4);
-        number_label->set_margin_end(10);
-        pack_start(*number_label, false, false);
+    static bool enabled() { return instance().active.load(std::memory_order_relaxed); }
 
-        // Create icon
-        icon_image = Gtk::manage(new Gtk::Image());
-        icon_image->set_size_request(32, 32);
-        pack_start(*icon_image, false, false);
+    static gint64 now_us() { return g_get_monotonic_time(); }
 
-        // Create vertical box for title and URL (each on their own line)
-        Gtk::Box* text_box = Gtk::manage(new Gtk::Box(Gtk::ORIENTATION_VERTICAL, 2));
+    // Starts tracing if URL_EDITOR_TRACE names an output file
+    void start_from_environment() {
+        const char* path = g_getenv("URL_EDITOR_TRACE");
+        if (path && *path) {
+            start(path);
+        }
+    }
 
-        // Create title label (single line, no wrapping, no ellipsize for horizontal scroll)
-        title_label = Gtk::manage(new Gtk::Label(title));
-        title_label->set_halign(Gtk::ALIGN_START);
-        title_label->set_valign(Gtk::ALIGN_START);
-        title_label->set_single_line_mode(true);
-        title_label->set_ellipsize(Pango::ELLIPSIZE_NONE);
-        text_box->pack_start(*title_label, false, false);
+    // Must be called on the thread that runs the main loop
+    bool start(const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file) return true;
+        file = std::fopen(path.c_str(), "w");
+        if (!file) {
+            g_warning("Cannot write trace file %s", path.c_str());
+            return false;
+        }
+        origin_us = now_us();
+        main_thread = std::this_thread::get_id();
+        std::fprintf(file, "[\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"main\"}},\n",
+                     thread_index());
+
+        last_beat_us = now_us();
+        heartbeat = Glib::signal_timeout().connect(sigc::mem_fun(*this, &Tracer::on_heartbeat),
+                                                   heartbeat_ms, Glib::PRIORITY_HIGH);
+        active = true;
+        return true;
+    }
 
-        // Create URL label (single line, no wrapping, blue and underlined, no ellipsize for horizontal scroll)
-        url_label = Gtk::manage(new Gtk::Label());
-        url_label->set_halign(Gtk::ALIGN_START);
-        url_label->set_valign(Gtk::ALIGN_START);
-        url_label->set_single_line_mode(true);
-        url_label->set_ellipsize(Pango::ELLIPSIZE_NONE);
-        url_label->set_selectable(false);
+    void stop() {
+        heartbeat.disconnect();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!file) return;
+        active = false;
+        // Closes the array after the trailing comma of the last event
+        std::fputs("{\"name\":\"trace_end\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":0}\n]\n", file);
+        std::fclose(file);
+        file = nullptr;
+    }
 
-        // Make it look like a link (blue and underlined via markup)
-        Glib::ustring url_markup = "<span underline=\"single\" color=\"#0000FF\">" +
-                                   Glib::Markup::escape_text(url) + "</span>";
-        url_label->set_markup(url_markup);
+    // Called by TraceSpan; name must be a string literal
+    void enter() { span_depth()++; }
 
-        text_box->pack_start(*url_label, false, false);
+    void leave(const char* name, gint64 start_us, gint64 end_us, long count) {
+        // Only outermost main-thread spans are candidates for a stall
+        if (--span_depth() == 0 && std::this_thread::get_id() == main_thread && end_us - start_us > longest_span_us) {
+            longest_span_us = end_us - start_us;
+            longest_span = name;
+        }
 
-        pack_start(*text_box, true, true);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!file) return;
+        std::fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT,
+                     name, thread_index(), start_us - origin_us, end_us - start_us);
+        if (count >= 0) {
+            std::fprintf(file, ",\"args\":{\"count\":%ld}", count);
+        }
+        std::fputs("},\n", file);
+    }
 
-        show_all();
+private:
+    static const unsigned int heartbeat_ms = 4;
+    static const gint64 stall_us = 16000;
+
+    // Small stable per-thread numbers read better in the viewer than
+    // pthread ids
+    static int thread_index() {
+        static std::atomic<int> next_index{1};
+        thread_local int index = next_index++;
+        return index;
     }
 
-    void set_icon(Glib::RefPtr<Gdk::Pixbuf> pixbuf) {
-        if (pixbuf) {
-            icon_image->set(pixbuf->scale_simple(32, 32, Gdk::INTERP_BILINEAR));
+    static int& span_depth() {
+        thread_local int depth = 0;
+        return depth;
+    }
+
+    // Runs on the main loop; a late beat means the loop was blocked
+    bool on_heartbeat() {
+        gint64 now = now_us();
+        gint64 blocked_us = now - last_beat_us - heartbeat_ms * 1000;
+        if (blocked_us > stall_us) {
+            const char* culprit = longest_span ? longest_span : "untraced";
+            g_warning("Main loop blocked for %" G_GINT64_FORMAT " ms (longest span: %s)", blocked_us / 1000, culprit);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (file) {
+                std::fprintf(file, "{\"name\":\"stall\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%" G_GINT64_FORMAT
+                             ",\"dur\":%" G_GINT64_FORMAT ",\"args\":{\"span\":\"%s\"}},\n",
+                             thread_index(), now - blocked_us - origin_us, blocked_us, culprit);
+            }
         }
+        last_beat_us = now;
+        longest_span = nullptr;
+        longest_span_us = 0;
+        return true;
     }
 
-    void set_number(int number) {
-        number_label->set_text(Glib::ustring::compose("%1.", number));
+    std::atomic<bool> active{false};
+    std::mutex mutex;
+    FILE* file = nullptr;
+    gint64 origin_us = 0;
+    std::thread::id main_thread;
+    sigc::connection heartbeat;
+
+    // Main thread only
+    gint64 last_beat_us = 0;
+    const char* longest_span = nullptr;
+    gint64 longest_span_us = 0;
+};
+
+// Records the enclosing scope as a trace span. Costs one relaxed load when
+// tracing is off.
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name) : name(Tracer::enabled() ? name : nullptr) {
+        if (this->name) {
+            start_us = Tracer::now_us();
+            Tracer::instance().enter();
+        }
     }
 
-    void set_title(const Glib::ustring& new_title) {
-        title_text = new_title;
-        title_label->set_text(new_title);
+    ~TraceSpan() {
+        if (name) {
+            Tracer::instance().leave(name, start_us, Tracer::now_us(), count);
+        }
     }
 
-    Glib::ustring get_url() const { return url_text; }
-    Glib::ustring get_title() const { return title_text; }
+    // Shown as the span's "count" argument (rows, bytes, ...)
+    void set_count(long value) { count = value; }
 
 private:
-    Gtk::Label* number_label;
-    Gtk::Image* icon_image;
-    Gtk::Label* title_label;
-    Gtk::Label* url_label;
-    Glib::ustring title_text;
-    Glib::ustring url_text;
+    const char* name;
+    gint64 start_us = 0;
+    long count = -1;
 };
 
-class UrlEditorWindow : public Gtk::Window {
-public:
-    UrlEditorWindow() {
-        set_title("URL Editor");
-        set_default_size(900, 1000); // WxH
-        set_border_width(10);
+struct UrlEntry {
+    Glib::ustring title;
+    Glib::ustring url;
 
-        // Create main box
-        main_box = Gtk::manage(new Gtk::Box(Gtk::ORIENTATION_VERTICAL, 10));
-        add(*main_box);
+    UrlEntry(const Glib::ustring& t, const Glib::ustring& u) : title(t), url(u) {}
+};
 
-        // Create header box with URL count
-        header_box = Gtk::manage(new Gtk::Box(Gtk::ORIENTATION_HORIZONTAL, 10));
+// Turns text of any charset into UTF-8 without exceptions. Pure ASCII and
+// valid UTF-8 (unless another charset was declared) come back unchanged
+// after a validation pass; everything else goes through g_iconv. Opening a
+// converter is far slower than running one, so handles are pooled per
+// charset and reused by whichever fetch thread needs one next.
+class TextDecoder {
+public:
+    // Converts text declared as charset (empty if unknown). Undeclared
+    // text that is not UTF-8 is taken to be in fallback; bytes that still
+    // don't convert become U+FFFD.
+    static std::string to_utf8(const std::string& text, const std::string& charset, const char* fallback) {
+        std::string name = charset.empty() ? std::string() : canonical_charset(charset);
+        if (is_ascii(text)) {
+            // 7-bit charsets hide their text behind escape sequences
+            // (ISO-2022), "~{" (HZ) or '+' (UTF-7); undeclared escapes are
+            // nearly always ISO-2022-JP
+            if (name.empty() && text.find('\x1b') != std::string::npos) {
+                name = "iso-2022-jp";
+            }
+            if (!seven_bit_charset(name) || text.find_first_of("\x1b~+") == std::string::npos) return text;
+        }
+        if (name.empty() || name == "utf-8") {
+            if (g_utf8_validate(text.data(), text.size(), nullptr)) return text;
+            if (name.empty()) {
+                name = canonical_charset(fallback);
+            }
+        }
 
-        url_count_label = Gtk::manage(new Gtk::Label("URLs: 0"));
-        url_count_label->set_halign(Gtk::ALIGN_START);
-        header_box->pack_start(*url_count_label, false, false);
-        header_box->pack_end(*Gtk::manage(new Gtk::Label()), true, true);
+        std::string result;
+        if (name != "utf-8" && convert(text, name, result)) return result;
+        // A charset iconv doesn't know: try the fallback before giving up
+        std::string fallback_name = canonical_charset(fallback);
+        if (fallback_name != name && fallback_name != "utf-8" && convert(text, fallback_name, result)) return result;
+        gchar* valid = g_utf8_make_valid(text.data(), text.size());
+        result = valid;
+        g_free(valid);
+        return result;
+    }
 
-        // Create mode selection
-        Gtk::Box* mode_box = Gtk::manage(new Gtk::Box(Gtk::ORIENTATION_HORIZONTAL, 10));
-        Gtk::Label* mode_label = Gtk::manage(new Gtk::Label("Input format:"));
-        mode_label->set_halign(Gtk::ALIGN_START);
-        mode_box->pack_start(*mode_label, false, false);
+    // The charset parameter of a Content-Type header, if any
+    static std::string charset_from_content_type(const std::string& content_type) {
+        std::string lower = ascii_lower(content_type);
+        size_t pos = lower.find("charset=");
+        if (pos == std::string::npos) return "";
+        return charset_value(lower, pos + 8);
+    }
 
-        mode1_radio = Gtk::manage(new Gtk::RadioButton("Title-URL pairs (with blank lines)"));
-        Gtk::RadioButtonGroup group = mode1_radio->get_group();
-        mode2_radio = Gtk::manage(new Gtk::RadioButton(group, "URLs only (one per line, optional # title)"));
-        mode2_radio->set_active(true); // Default to mode 2
+    // The charset of a <meta charset> or <meta http-equiv="Content-Type">
+    // tag near the start of a page, as browsers look for it
+    static std::string charset_from_html(const std::string& html) {
+        std::string head = ascii_lower(html.substr(0, 4096));
+        for (size_t meta = head.find("<meta"); meta != std::string::npos; meta = head.find("<meta", meta + 5)) {
+            size_t end = head.find('>', meta);
+            size_t pos = head.find("charset", meta);
+            if (pos == std::string::npos || pos > end) continue;
+            pos = head.find_first_not_of(" \t\r\n", pos + 7);
+            if (pos == std::string::npos || head[pos] != '=') continue;
+            pos = head.find_first_not_of(" \t\r\n", pos + 1);
+            if (pos == std::string::npos) break;
+            std::string charset = charset_value(head, pos);
+            if (!charset.empty()) return charset;
+        }
+        return "";
+    }
 
-        mode_box->pack_start(*mode1_radio, false, false);
-        mode_box->pack_start(*mode2_radio, false, false);
-        main_box->pack_start(*mode_box, false, false);
+private:
+    // Eight bytes per step; any byte with the top bit set ends the fast path
+    static bool is_ascii(const std::string& text) {
+        const char* data = text.data();
+        size_t size = text.size();
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t word;
+            memcpy(&word, data + i, 8);
+            if (word & 0x8080808080808080ULL) return false;
+        }
+        for (; i < size; ++i) {
+            if ((unsigned char)data[i] & 0x80) return false;
+        }
+        return true;
+    }
 
-        main_box->pack_start(*header_box, false, false);
+    static bool seven_bit_charset(const std::string& name) {
+        return name.compare(0, 9, "iso-2022-") == 0 || name == "hz-gb-2312" || name == "utf-7";
+    }
 
-        // Create scrolled window for text view
-        url_text_scrolled = Gtk::manage(new Gtk::ScrolledWindow());
-        url_text_scrolled->set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
-        url_text_scrolled->set_min_content_height(150);
-        url_text_scrolled->set_vexpand(false);
+    static std::string ascii_lower(const std::string& text) {
+        std::string lower = text;
+        for (char& c : lower) {
+            c = g_ascii_tolower(c);
+        }
+        return lower;
+    }
 
-        url_text_view = Gtk::manage(new Gtk::TextView());
-        url_text_view->set_editable(true);
-        url_text_view->set_cursor_visible(true);
-        url_text_view->set_wrap_mode(Gtk::WRAP_NONE);
-        url_text_view->set_monospace(true);
-        url_text_scrolled->add(*url_text_view);
-        main_box->pack_start(*url_text_scrolled, false, false);
+    // A charset name starting at pos, with or without quotes
+    static std::string charset_value(const std::string& text, size_t pos) {
+        if (pos < text.size() && (text[pos] == '"' || text[pos] == '\'')) {
+            ++pos;
+        }
+        size_t end = text.find_first_of("\"'; \t\r\n>/", pos);
+        return text.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    }
 
-        // Create scrolled window for list (with horizontal scrolling)
-        scrolled_window = Gtk::manage(new Gtk::ScrolledWindow());
-        scrolled_window->set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
-        scrolled_window->set_vexpand(true);
-        scrolled_window->set_hexpand(true);
-        scrolled_window->set_min_content_width(600); // Minimum width before horizontal scroll appears
+    // The labels pages use for charsets iconv calls something else, as the
+    // WHATWG Encoding Standard maps them (Latin-1 is read as windows-1252)
+    static std::string canonical_charset(const std::string& charset) {
+        static const std::unordered_map<std::string, std::string> aliases = {
+            {"utf8", "utf-8"}, {"unicode-1-1-utf-8", "utf-8"},
+            {"iso-8859-1", "windows-1252"}, {"iso8859-1", "windows-1252"}, {"latin1", "windows-1252"},
+            {"us-ascii", "windows-1252"}, {"ascii", "windows-1252"},
+            {"x-sjis", "shift_jis"}, {"sjis", "shift_jis"}, {"ms_kanji", "shift_jis"},
+            {"gb2312", "gbk"}, {"x-gbk", "gbk"}, {"ks_c_5601-1987", "euc-kr"},
+            {"x-mac-cyrillic", "maccyrillic"}, {"tis-620", "windows-874"},
+            {"csiso2022jp", "iso-2022-jp"}, {"hz", "hz-gb-2312"}, {"utf7", "utf-7"}
+        };
+        std::string name = ascii_lower(charset);
+        auto alias = aliases.find(name);
+        return alias != aliases.end() ? alias->second : name;
+    }
 
-        // Create list box
-        list_box = Gtk::manage(new Gtk::ListBox());
-        list_box->set_selection_mode(Gtk::SELECTION_SINGLE);
-        list_box->set_hexpand(false); // Allow list to expand beyond window width for horizontal scroll
-        scrolled_window->add(*list_box);
-        main_box->pack_start(*scrolled_window, true, true);
+    static bool convert(const std::string& text, const std::string& charset, std::string& result) {
+        GIConv converter = acquire(charset);
+        if (converter == (GIConv)-1) return false;
+
+        result.clear();
+        result.reserve(text.size() * 2);
+        gchar* in = const_cast<gchar*>(text.data());
+        gsize in_left = text.size();
+        char buffer[4096];
+        while (in_left > 0) {
+            gchar* out = buffer;
+            gsize out_left = sizeof(buffer);
+            gsize converted = g_iconv(converter, &in, &in_left, &out, &out_left);
+            int error = errno;
+            result.append(buffer, out - buffer);
+            if (converted != (gsize)-1) continue;
+            if (error == EILSEQ || error == EINVAL) {
+                // Skip the byte that doesn't belong to the charset
+                result += "\xEF\xBF\xBD";
+                ++in;
+                --in_left;
+                g_iconv(converter, nullptr, nullptr, nullptr, nullptr);
+            } else if (error != E2BIG) {
+                release(charset, converter);
+                return false;
+            }
+        }
+        // Flush any shift state (ISO-2022-JP ends in ASCII mode)
+        gchar* out = buffer;
+        gsize out_left = sizeof(buffer);
+        g_iconv(converter, nullptr, nullptr, &out, &out_left);
+        result.append(buffer, out - buffer);
+        release(charset, converter);
+        return true;
+    }
 
-        // Connect signals
-        list_box->signal_row_activated().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_row_activated));
-        list_box->signal_button_press_event().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_button_press));
-        list_box->signal_row_selected().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_row_selected));
+    struct Pool {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::vector<GIConv>> idle;
+        std::unordered_set<std::string> unsupported;
+    };
 
-        // Add keyboard shortcuts - handle key press events
-        signal_key_press_event().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_key_press), false);
+    // Never destroyed: fetch threads may still be converting at exit
+    static Pool& pool() {
+        static Pool* instance = new Pool();
+        return *instance;
+    }
 
-        // Create button box
-        button_box = Gtk::manage(new Gtk::Box(Gtk::ORIENTATION_HORIZONTAL, 10));
+    static GIConv acquire(const std::string& charset) {
+        Pool& shared = pool();
+        {
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            if (shared.unsupported.count(charset)) return (GIConv)-1;
+            std::vector<GIConv>& idle = shared.idle[charset];
+            if (!idle.empty()) {
+                GIConv converter = idle.back();
+                idle.pop_back();
+                return converter;
+            }
+        }
+        GIConv converter = g_iconv_open("UTF-8", charset.c_str());
+        if (converter == (GIConv)-1) {
+            g_warning("Unsupported charset: %s", charset.c_str());
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            shared.unsupported.insert(charset);
+        }
+        return converter;
+    }
 
-        load_button = Gtk::manage(new Gtk::Button("Load from text"));
-        save_button = Gtk::manage(new Gtk::Button("Export to text"));
-        refresh_button = Gtk::manage(new Gtk::Button("Refresh Icons"));
+    static void release(const std::string& charset, GIConv converter) {
+        g_iconv(converter, nullptr, nullptr, nullptr, nullptr);
+        Pool& shared = pool();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        shared.idle[charset].push_back(converter);
+    }
+};
 
-        // Movement and delete buttons
-        move_up_button = Gtk::manage(new Gtk::Button("↑"));
-        move_down_button = Gtk::manage(new Gtk::Button("↓"));
-        delete_button = Gtk::manage(new Gtk::Button("Delete"));
-        copy_url_button = Gtk::manage(new Gtk::Button("Copy URL"));
-        open_chromium_button = Gtk::manage(new Gtk::Button("Open in Chromium"));
+// Parses the text formats accepted by the text field, one line at a time so
+// input can be streamed:
+//   mode 1: a title line followed by a URL line, pairs separated by blank lines
+//   mode 2: one URL per line, optionally followed by " # Title"
+class UrlLineParser {
+public:
+    explicit UrlLineParser(bool mode2) : mode2(mode2) {}
 
-        load_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_load_clicked));
-        save_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_save_clicked));
-        refresh_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_refresh_clicked));
-        move_up_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_move_up_clicked));
-        move_down_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_move_down_clicked));
-        delete_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_delete_clicked));
-        copy_url_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_copy_url_clicked));
-        open_chromium_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_open_chromium_clicked));
+    // Returns true when the line completed an entry (appended to entries)
+    bool feed(std::string line, std::vector<UrlEntry>& entries) {
+        // Trim whitespace
+        line.erase(0, line.find_first_not_of(" \t\n\r"));
+        line.erase(line.find_last_not_of(" \t\n\r") + 1);
 
-        button_box->pack_start(*load_button, false, false);
-        button_box->pack_start(*save_button, false, false);
-        button_box->pack_start(*refresh_button, false, false);
-        button_box->pack_start(*Gtk::manage(new Gtk::Separator(Gtk::ORIENTATION_VERTICAL)), false, false);
-        button_box->pack_start(*move_up_button, false, false);
-        button_box->pack_start(*move_down_button, false, false);
-        button_box->pack_start(*delete_button, false, false);
-        button_box->pack_start(*copy_url_button, false, false);
-        button_box->pack_start(*open_chromium_button, false, false);
-        button_box->pack_end(*Gtk::manage(new Gtk::Label()), true, true);
+        if (line.empty()) {
+            expecting_url = false;
+            return false;
+        }
 
-        // Initially disable movement buttons (no selection)
-        move_up_button->set_sensitive(false);
-        move_down_button->set_sensitive(false);
-        delete_button->set_sensitive(false);
-        copy_url_button->set_sensitive(false);
+        if (mode2) {
+            // Parse line: URL # Title or just URL
+            std::string url_str = line;
+            std::string title_str;
+
+            // Check for # comment
+            size_t hash_pos = line.find(" # ");
+            if (hash_pos != std::string::npos) {
+                url_str = line.substr(0, hash_pos);
+                title_str = line.substr(hash_pos + 3); // Skip " # "
+                // Trim both
+                url_str.erase(0, url_str.find_first_not_of(" \t"));
+                url_str.erase(url_str.find_last_not_of(" \t") + 1);
+                title_str.erase(0, title_str.find_first_not_of(" \t"));
+                title_str.erase(title_str.find_last_not_of(" \t") + 1);
+            } else {
+                // No title provided, use URL as title for now
+                // (Website title will be fetched with favicon)
+                title_str = url_str;
+            }
 
-        main_box->pack_start(*button_box, false, false);
+            entries.push_back(UrlEntry(to_ustring(title_str), to_ustring(url_str)));
+            return true;
+        }
 
-        // Create status bar
-        status_box = Gtk::manage(new Gtk::Box(Gtk::ORIENTATION_HORIZONTAL, 10));
-        status_label = Gtk::manage(new Gtk::Label("Ready"));
-        status_label->set_halign(Gtk::ALIGN_START);
-        status_box->pack_start(*status_label, true, true);
+        Glib::ustring ustring_line = to_ustring(line);
+        if (!expecting_url) {
+            current_title = ustring_line;
+            expecting_url = true;
+            return false;
+        }
+        entries.push_back(UrlEntry(current_title, ustring_line));
+        expecting_url = false;
+        return true;
+    }
 
-        progress_bar = Gtk::manage(new Gtk::ProgressBar());
-        progress_bar->set_visible(false);
-        status_box->pack_end(*progress_bar, false, false);
+private:
+    // Treat the text as UTF-8, falling back to the locale encoding
+    static Glib::ustring to_ustring(const std::string& text) {
+        const char* locale_charset = nullptr;
+        g_get_charset(&locale_charset);
+        return TextDecoder::to_utf8(text, "", locale_charset);
+    }
 
-        main_box->pack_start(*status_box, false, false);
+    bool mode2;
+    bool expecting_url = false;
+    Glib::ustring current_title;
+};
 
-        show_all();
+// Formats an entry as a mode 2 line ("URL # Title", or just the URL).
+// Every writer of mode 2 text goes through here, so they can't drift apart.
+inline std::string format_mode2_line(const std::string& title, const std::string& url) {
+    std::string line = url;
+    if (!title.empty() && title != url) {
+        line += " # " + title;
+    }
+    return line;
+}
 
-        // Apply custom CSS for thicker scrollbars and darker background
-        Glib::RefPtr<Gtk::CssProvider> css_provider = Gtk::CssProvider::create();
-        css_provider->load_from_data(
-            "window {"
-            "  background-color: #e0e0e0;"
-            "}"
-            "scrolledwindow scrollbar {"
-            "  min-width: 20px;"
-            "  min-height: 20px;"
-            "}"
-            "scrolledwindow scrollbar slider {"
-            "  min-width: 20px;"
-            "  min-height: 20px;"
-            "}"
-        );
-        Glib::RefPtr<Gdk::Screen> screen = Gdk::Screen::get_default();
-        Gtk::StyleContext::add_provider_for_screen(
-            screen, css_provider, GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+inline std::vector<UrlEntry> parse_url_text(const std::string& text, bool mode2) {
+    std::vector<UrlEntry> entries;
+    UrlLineParser parser(mode2);
+    std::istringstream stream(text);
+    std::string line;
+    while (std::getline(stream, line)) {
+        parser.feed(line, entries);
+    }
+    return entries;
+}
 
-        // Initialize curl
-        curl_global_init(CURL_GLOBAL_DEFAULT);
+// Follows a URL list that other programs append to. Each read() parses only
+// the bytes added since the previous one; a line without its newline yet is
+// held back until it is complete. A file that shrank, was replaced (new
+// inode) or changed before the last read offset counts as rewritten, and
+// read() then parses it from the start, including a last line that has no
+// newline (many editors write none).
+class FileTailer {
+public:
+    enum Result { UNCHANGED, APPENDED, REWRITTEN, FAILED };
 
-        // Don't load URLs on startup - user will paste them
-    }
+    FileTailer(const std::string& path, bool mode2) : path(path), mode2(mode2), parser(mode2) {}
 
-    ~UrlEditorWindow() {
-        curl_global_cleanup();
-    }
+    const std::string& file_path() const { return path; }
 
-private:
-    void on_row_selected(Gtk::ListBoxRow* row) {
-        // Store the currently selected row
-        current_selected_row = row;
-        // This is called when selection changes via user interaction
-        // But we also call update_button_states manually after moves
-        update_button_states(row);
-    }
+    // New entries go to entries; on REWRITTEN they are the whole file
+    Result read(std::vector<UrlEntry>& entries) {
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) return FAILED;
 
-    void on_move_up_clicked() {
-        // Try to get selected row - use stored reference if get_selected_row() fails
-        Gtk::ListBoxRow* selected_row = list_box->get_selected_row();
-        if (!selected_row) {
-            selected_row = current_selected_row;
+        struct stat info;
+        if (fstat(fileno(file), &info) != 0) {
+            std::fclose(file);
+            return FAILED;
         }
-        if (!selected_row) return;
 
-        int current_index = selected_row->get_index();
+        bool rewritten = !started || info.st_ino != inode || info.st_size < offset || !anchors_match(file);
+        if (rewritten) {
+            started = true;
+            inode = info.st_ino;
+            offset = 0;
+            pending_line.clear();
+            last_line_parsed = false;
+            head.clear();
+            tail.clear();
+            parser = UrlLineParser(mode2);
+        } else if (info.st_size == offset) {
+            std::fclose(file);
+            return UNCHANGED;
+        }
+
+        std::string data;
+        std::fseek(file, offset, SEEK_SET);
+        char buffer[65536];
+        size_t count;
+        while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            data.append(buffer, count);
+        }
+        std::fclose(file);
+
+        if (last_line_parsed && !data.empty() && data[0] != '\n' && data[0] != '\r') {
+            // The unterminated last line parsed before has grown; its
+            // entry changed, so the whole file is read again
+            started = false;
+            return read(entries);
+        }
+        remember_anchors(data);
+        offset += data.size();
+        if (last_line_parsed && !data.empty()) {
+            // It was complete after all; skip its line break
+            pending_line.clear();
+            data.erase(0, data.compare(0, 2, "\r\n") == 0 ? 2 : 1);
+            last_line_parsed = false;
+        }
+
+        // Only complete lines are parsed
+        pending_line += data;
+        size_t line_start = 0;
+        size_t newline;
+        while ((newline = pending_line.find('\n', line_start)) != std::string::npos) {
+            parser.feed(pending_line.substr(line_start, newline - line_start), entries);
+            line_start = newline + 1;
+        }
+        pending_line.erase(0, line_start);
+        // A full read takes the last line as it is; between appends it is
+        // held back, as the writer is probably still busy with it
+        if (rewritten && !pending_line.empty()) {
+            parser.feed(pending_line, entries);
+            last_line_parsed = true;
+        }
+        return rewritten ? REWRITTEN : APPENDED;
+    }
+
+private:
+    // Edits before the read offset show up in the first or the last bytes
+    // read so far; a change elsewhere in the middle of a long file that
+    // keeps its size growing is not noticed
+    bool anchors_match(FILE* file) {
+        std::string bytes(head.size(), '\0');
+        if (std::fseek(file, 0, SEEK_SET) != 0 || std::fread(&bytes[0], 1, bytes.size(), file) != bytes.size() || bytes != head) {
+            return false;
+        }
+        bytes.assign(tail.size(), '\0');
+        return std::fseek(file, offset - (long)tail.size(), SEEK_SET) == 0 &&
+               std::fread(&bytes[0], 1, bytes.size(), file) == bytes.size() && bytes == tail;
+    }
+
+    void remember_anchors(const std::string& data) {
+        const size_t anchor_size = 4096;
+        if (head.size() < anchor_size) {
+            head += data.substr(0, anchor_size - head.size());
+        }
+        tail += data;
+        if (tail.size() > anchor_size) {
+            tail.erase(0, tail.size() - anchor_size);
+        }
+    }
+
+    std::string path;
+    bool mode2;
+    UrlLineParser parser;
+    bool started = false;
+    ino_t inode = 0;
+    long offset = 0;
+    std::string pending_line;
+    bool last_line_parsed = false; // pending_line was parsed as a final line
+    std::string head;
+    std::string tail;
+};
+
+enum FetchStatus {
+    FETCH_PENDING = 0, // Not fetched yet
+    FETCH_DONE = 1,    // Favicon downloaded
+    FETCH_FAILED = 2   // No favicon found, fallback icon shown
+};
+
+// One row of the saved session
+struct SessionEntry {
+    std::string title;
+    std::string url;
+    std::string icon_key;
+    int status = FETCH_PENDING;
+    gint64 fetched_at = 0;
+};
+
+// Keeps the working list in an SQLite database so it survives restarts.
+// Icons are stored once per key (scheme://host) as PNG and referenced by rows.
+class SessionStore {
+public:
+    explicit SessionStore(const std::string& path) {
+        if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+            g_warning("Failed to open session database %s: %s", path.c_str(), sqlite3_errmsg(db));
+            sqlite3_close(db);
+            db = nullptr;
+            return;
+        }
+
+        exec("PRAGMA journal_mode=WAL");
+        exec("PRAGMA synchronous=NORMAL");
+        exec("CREATE TABLE IF NOT EXISTS entries ("
+             "position INTEGER PRIMARY KEY, title TEXT NOT NULL, url TEXT NOT NULL, "
+             "status INTEGER NOT NULL, fetched_at INTEGER NOT NULL, icon_key TEXT NOT NULL)");
+        exec("CREATE TABLE IF NOT EXISTS icons (key TEXT PRIMARY KEY, png BLOB NOT NULL)");
+    }
+
+    ~SessionStore() {
+        if (db) {
+            sqlite3_close(db);
+        }
+    }
+
+    bool is_open() const { return db != nullptr; }
+
+    bool load(std::vector<SessionEntry>& entries, std::unordered_map<std::string, std::string>& icons) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!db) return false;
+
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db, "SELECT title, url, status, fetched_at, icon_key FROM entries ORDER BY position",
+                               -1, &stmt, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            SessionEntry entry;
+            entry.title = column_text(stmt, 0);
+            entry.url = column_text(stmt, 1);
+            entry.status = sqlite3_column_int(stmt, 2);
+            entry.fetched_at = sqlite3_column_int64(stmt, 3);
+            entry.icon_key = column_text(stmt, 4);
+            entries.push_back(std::move(entry));
+        }
+        sqlite3_finalize(stmt);
+
+        if (sqlite3_prepare_v2(db, "SELECT key, png FROM icons", -1, &stmt, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char* png = (const char*)sqlite3_column_blob(stmt, 1);
+            icons[column_text(stmt, 0)] = std::string(png ? png : "", sqlite3_column_bytes(stmt, 1));
+        }
+        sqlite3_finalize(stmt);
+        return true;
+    }
+
+    // Replaces the saved list in one transaction, so a crash mid-write
+    // leaves the previous session intact. Writes are applied in sequence
+    // order, whichever thread gets to the database first.
+    bool save(long sequence, const std::vector<SessionEntry>& entries,
+              const std::vector<std::pair<std::string, std::string>>& new_icons) {
+        Turn turn(*this, sequence);
+        if (!db || !exec("BEGIN IMMEDIATE")) return false;
+        bool ok = exec("DELETE FROM entries");
+
+        sqlite3_stmt* stmt = nullptr;
+        if (ok && sqlite3_prepare_v2(db, "INSERT INTO entries (position, title, url, status, fetched_at, icon_key) "
+                                         "VALUES (?, ?, ?, ?, ?, ?)", -1, &stmt, nullptr) == SQLITE_OK) {
+            for (size_t i = 0; ok && i < entries.size(); ++i) {
+                const SessionEntry& entry = entries[i];
+                sqlite3_bind_int64(stmt, 1, (sqlite3_int64)i);
+                sqlite3_bind_text(stmt, 2, entry.title.data(), entry.title.size(), SQLITE_STATIC);
+                sqlite3_bind_text(stmt, 3, entry.url.data(), entry.url.size(), SQLITE_STATIC);
+                sqlite3_bind_int(stmt, 4, entry.status);
+                sqlite3_bind_int64(stmt, 5, entry.fetched_at);
+                sqlite3_bind_text(stmt, 6, entry.icon_key.data(), entry.icon_key.size(), SQLITE_STATIC);
+                ok = sqlite3_step(stmt) == SQLITE_DONE;
+                sqlite3_reset(stmt);
+            }
+            sqlite3_finalize(stmt);
+        } else {
+            ok = false;
+        }
+
+        return finish(ok && save_icons(new_icons));
+    }
+
+    // Rewrites only the given rows (their position in the last full save
+    // first), for changes that leave the list's order alone
+    bool update(long sequence, const std::vector<std::pair<long, SessionEntry>>& rows,
+                const std::vector<std::pair<std::string, std::string>>& new_icons) {
+        Turn turn(*this, sequence);
+        if (!db || !exec("BEGIN IMMEDIATE")) return false;
+
+        sqlite3_stmt* stmt = nullptr;
+        bool ok = sqlite3_prepare_v2(db, "UPDATE entries SET title = ?, status = ?, fetched_at = ?, icon_key = ? "
+                                         "WHERE position = ?", -1, &stmt, nullptr) == SQLITE_OK;
+        for (size_t i = 0; ok && i < rows.size(); ++i) {
+            const SessionEntry& entry = rows[i].second;
+            sqlite3_bind_text(stmt, 1, entry.title.data(), entry.title.size(), SQLITE_STATIC);
+            sqlite3_bind_int(stmt, 2, entry.status);
+            sqlite3_bind_int64(stmt, 3, entry.fetched_at);
+            sqlite3_bind_text(stmt, 4, entry.icon_key.data(), entry.icon_key.size(), SQLITE_STATIC);
+            sqlite3_bind_int64(stmt, 5, (sqlite3_int64)rows[i].first);
+            ok = sqlite3_step(stmt) == SQLITE_DONE;
+            sqlite3_reset(stmt);
+        }
+        sqlite3_finalize(stmt);
+        return finish(ok && save_icons(new_icons));
+    }
+
+private:
+    // Holds the database for the write numbered sequence once all earlier
+    // writes are done; every number handed out must reach the store
+    class Turn {
+    public:
+        Turn(SessionStore& store, long sequence) : store(store), lock(store.mutex), sequence(sequence) {
+            store.turn_changed.wait(lock, [&store, sequence]() { return store.saved_sequence + 1 >= sequence; });
+        }
+        ~Turn() {
+            store.saved_sequence = std::max(store.saved_sequence, sequence);
+            store.turn_changed.notify_all();
+        }
+    private:
+        SessionStore& store;
+        std::unique_lock<std::mutex> lock;
+        long sequence;
+    };
+
+    bool save_icons(const std::vector<std::pair<std::string, std::string>>& new_icons) {
+        if (new_icons.empty()) return true;
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO icons (key, png) VALUES (?, ?)", -1, &stmt, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        bool ok = true;
+        for (size_t i = 0; ok && i < new_icons.size(); ++i) {
+            sqlite3_bind_text(stmt, 1, new_icons[i].first.data(), new_icons[i].first.size(), SQLITE_STATIC);
+            sqlite3_bind_blob(stmt, 2, new_icons[i].second.data(), new_icons[i].second.size(), SQLITE_STATIC);
+            ok = sqlite3_step(stmt) == SQLITE_DONE;
+            sqlite3_reset(stmt);
+        }
+        sqlite3_finalize(stmt);
+        return ok;
+    }
+
+    bool finish(bool ok) {
+        if (!ok) {
+            g_warning("Failed to save session: %s", sqlite3_errmsg(db));
+            exec("ROLLBACK");
+            return false;
+        }
+        return exec("COMMIT");
+    }
+
+    bool exec(const char* sql) {
+        char* error = nullptr;
+        if (sqlite3_exec(db, sql, nullptr, nullptr, &error) != SQLITE_OK) {
+            g_warning("Session database error: %s", error ? error : "unknown");
+            sqlite3_free(error);
+            return false;
+        }
+        return true;
+    }
+
+    static std::string column_text(sqlite3_stmt* stmt, int column) {
+        const char* text = (const char*)sqlite3_column_text(stmt, column);
+        return text ? std::string(text, sqlite3_column_bytes(stmt, column)) : std::string();
+    }
+
+    sqlite3* db = nullptr;
+    std::mutex mutex;
+    std::condition_variable turn_changed;
+    long saved_sequence = 0;
+};
+
+// What the last title fetch of a page returned
+struct PageMetadata {
+    std::string title;
+    std::string final_url;
+    long http_status = 0;
+    std::string content_type;
+    std::string etag;
+    std::string last_modified;
+    gint64 fetched_at = 0;
+};
+
+// Canonical form of a URL for cache lookups: scheme and host lowercased,
+// default ports and the fragment dropped, an empty path written as "/"
+inline std::string canonical_url(const std::string& url) {
+    std::string result = url.find("://") == std::string::npos ? "http://" + url : url;
+    size_t fragment = result.find('#');
+    if (fragment != std::string::npos) {
+        result.erase(fragment);
+    }
+
+    size_t scheme_end = result.find("://");
+    size_t host_start = scheme_end + 3;
+    size_t host_end = result.find_first_of("/?", host_start);
+    if (host_end == std::string::npos) {
+        host_end = result.size();
+    }
+    for (size_t i = 0; i < host_end; ++i) {
+        result[i] = g_ascii_tolower(result[i]);
+    }
+
+    const char* default_port = result.compare(0, scheme_end, "http") == 0 ? ":80"
+                             : result.compare(0, scheme_end, "https") == 0 ? ":443" : nullptr;
+    if (default_port) {
+        size_t port_length = std::strlen(default_port);
+        if (host_end - host_start > port_length &&
+            result.compare(host_end - port_length, port_length, default_port) == 0) {
+            result.erase(host_end - port_length, port_length);
+            host_end -= port_length;
+        }
+    }
+    if (host_end == result.size() || result[host_end] == '?') {
+        result.insert(host_end, "/");
+    }
+    return result;
+}
+
+// Whether url points at a link shortener, whose host says nothing about
+// the page behind it
+inline bool is_short_link(const std::string& url) {
+    static const std::unordered_set<std::string> shorteners = {
+        "t.co", "bit.ly", "bitly.com", "j.mp", "lnkd.in", "goo.gl", "tinyurl.com", "ow.ly", "buff.ly",
+        "is.gd", "v.gd", "dlvr.it", "fb.me", "amzn.to", "trib.al", "rebrand.ly", "shorturl.at", "cutt.ly",
+        "t.ly", "tiny.cc", "bl.ink", "wp.me", "redd.it", "youtu.be", "flip.it", "ift.tt", "s.id", "rb.gy"
+    };
+    size_t host_start = url.find("://");
+    if (host_start == std::string::npos) return false;
+    host_start += 3;
+    size_t host_end = url.find_first_of(":/?#", host_start);
+    std::string host = url.substr(host_start, host_end == std::string::npos ? std::string::npos : host_end - host_start);
+    for (char& c : host) {
+        c = g_ascii_tolower(c);
+    }
+    if (host.compare(0, 4, "www.") == 0) {
+        host.erase(0, 4);
+    }
+    return shorteners.count(host) > 0;
+}
+
+// Page titles and HTTP validators from earlier fetches. Kept in an SQLite
+// database and mirrored in a hash map, so lookups while a list loads are
+// O(1) and never touch the disk. Safe to use from fetch threads.
+class MetadataCache {
+public:
+    explicit MetadataCache(const std::string& path) {
+        if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+            g_warning("Failed to open metadata cache %s: %s", path.c_str(), sqlite3_errmsg(db));
+            sqlite3_close(db);
+            db = nullptr;
+            return;
+        }
+
+        sqlite3_exec(db, "PRAGMA journal_mode=WAL", nullptr, nullptr, nullptr);
+        sqlite3_exec(db, "PRAGMA synchronous=NORMAL", nullptr, nullptr, nullptr);
+        sqlite3_exec(db, "CREATE TABLE IF NOT EXISTS pages ("
+                         "url TEXT PRIMARY KEY, title TEXT NOT NULL, final_url TEXT NOT NULL, "
+                         "http_status INTEGER NOT NULL, content_type TEXT NOT NULL, etag TEXT NOT NULL, "
+                         "last_modified TEXT NOT NULL, fetched_at INTEGER NOT NULL)",
+                     nullptr, nullptr, nullptr);
+        sqlite3_exec(db, "CREATE TABLE IF NOT EXISTS redirects ("
+                         "url TEXT PRIMARY KEY, resolved_url TEXT NOT NULL, resolved_at INTEGER NOT NULL)",
+                     nullptr, nullptr, nullptr);
+
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db, "SELECT url, title, final_url, http_status, content_type, etag, "
+                                   "last_modified, fetched_at FROM pages", -1, &stmt, nullptr) == SQLITE_OK) {
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                PageMetadata& metadata = pages[column_text(stmt, 0)];
+                metadata.title = column_text(stmt, 1);
+                metadata.final_url = column_text(stmt, 2);
+                metadata.http_status = sqlite3_column_int(stmt, 3);
+                metadata.content_type = column_text(stmt, 4);
+                metadata.etag = column_text(stmt, 5);
+                metadata.last_modified = column_text(stmt, 6);
+                metadata.fetched_at = sqlite3_column_int64(stmt, 7);
+            }
+            sqlite3_finalize(stmt);
+        }
+        if (sqlite3_prepare_v2(db, "SELECT url, resolved_url FROM redirects", -1, &stmt, nullptr) == SQLITE_OK) {
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                redirects[column_text(stmt, 0)] = column_text(stmt, 1);
+            }
+            sqlite3_finalize(stmt);
+        }
+
+        if (sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO pages (url, title, final_url, http_status, "
+                                   "content_type, etag, last_modified, fetched_at) VALUES (?, ?, ?, ?, ?, ?, ?, ?)",
+                               -1, &insert_stmt, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO redirects (url, resolved_url, resolved_at) VALUES (?, ?, ?)",
+                               -1, &redirect_stmt, nullptr) != SQLITE_OK) {
+            g_warning("Metadata cache error: %s", sqlite3_errmsg(db));
+        }
+    }
+
+    ~MetadataCache() {
+        if (insert_stmt) {
+            sqlite3_finalize(insert_stmt);
+        }
+        if (redirect_stmt) {
+            sqlite3_finalize(redirect_stmt);
+        }
+        if (db) {
+            sqlite3_close(db);
+        }
+    }
+
+    bool is_open() const { return db != nullptr && insert_stmt != nullptr; }
+
+    bool lookup(const std::string& url, PageMetadata& metadata) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto page = pages.find(canonical_url(url));
+        if (page == pages.end()) return false;
+        metadata = page->second;
+        return true;
+    }
+
+    // The map is updated at once; the row is written afterwards under the
+    // database's own lock, so lookups from the main thread never wait for
+    // the disk. Whichever store() of a URL writes last writes its newest value.
+    void store(const std::string& url, const PageMetadata& new_metadata) {
+        std::string key = canonical_url(url);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pages[key] = new_metadata;
+        }
+        if (!insert_stmt) return;
+
+        std::lock_guard<std::mutex> db_lock(db_mutex);
+        PageMetadata metadata;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            metadata = pages[key];
+        }
+        sqlite3_bind_text(insert_stmt, 1, key.data(), key.size(), SQLITE_STATIC);
+        sqlite3_bind_text(insert_stmt, 2, metadata.title.data(), metadata.title.size(), SQLITE_STATIC);
+        sqlite3_bind_text(insert_stmt, 3, metadata.final_url.data(), metadata.final_url.size(), SQLITE_STATIC);
+        sqlite3_bind_int(insert_stmt, 4, (int)metadata.http_status);
+        sqlite3_bind_text(insert_stmt, 5, metadata.content_type.data(), metadata.content_type.size(), SQLITE_STATIC);
+        sqlite3_bind_text(insert_stmt, 6, metadata.etag.data(), metadata.etag.size(), SQLITE_STATIC);
+        sqlite3_bind_text(insert_stmt, 7, metadata.last_modified.data(), metadata.last_modified.size(), SQLITE_STATIC);
+        sqlite3_bind_int64(insert_stmt, 8, metadata.fetched_at);
+        if (sqlite3_step(insert_stmt) != SQLITE_DONE) {
+            g_warning("Failed to cache metadata for %s: %s", key.c_str(), sqlite3_errmsg(db));
+        }
+        sqlite3_reset(insert_stmt);
+    }
+
+    // Where a short link led when it was last expanded
+    bool lookup_redirect(const std::string& url, std::string& resolved_url) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto redirect = redirects.find(canonical_url(url));
+        if (redirect == redirects.end()) return false;
+        resolved_url = redirect->second;
+        return true;
+    }
+
+    void store_redirect(const std::string& url, const std::string& new_resolved_url) {
+        std::string key = canonical_url(url);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            redirects[key] = new_resolved_url;
+        }
+        if (!redirect_stmt) return;
+
+        std::lock_guard<std::mutex> db_lock(db_mutex);
+        std::string resolved_url;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            resolved_url = redirects[key];
+        }
+
+        sqlite3_bind_text(redirect_stmt, 1, key.data(), key.size(), SQLITE_STATIC);
+        sqlite3_bind_text(redirect_stmt, 2, resolved_url.data(), resolved_url.size(), SQLITE_STATIC);
+        sqlite3_bind_int64(redirect_stmt, 3, g_get_real_time() / G_USEC_PER_SEC);
+        if (sqlite3_step(redirect_stmt) != SQLITE_DONE) {
+            g_warning("Failed to cache redirect for %s: %s", key.c_str(), sqlite3_errmsg(db));
+        }
+        sqlite3_reset(redirect_stmt);
+    }
+
+private:
+    static std::string column_text(sqlite3_stmt* stmt, int column) {
+        const char* text = (const char*)sqlite3_column_text(stmt, column);
+        return text ? std::string(text, sqlite3_column_bytes(stmt, column)) : std::string();
+    }
+
+    sqlite3* db = nullptr;
+    sqlite3_stmt* insert_stmt = nullptr;
+    sqlite3_stmt* redirect_stmt = nullptr;
+    std::mutex mutex;    // The maps
+    std::mutex db_mutex; // The connection and its statements
+    std::unordered_map<std::string, PageMetadata> pages;
+    std::unordered_map<std::string, std::string> redirects; // short link -> destination
+};
+
+// Full page bodies kept for offline reading. Records are WARC/1.0 response
+// records, each compressed as its own zstd frame and appended to one file,
+// so any record can be decompressed alone. A tab-separated index beside it
+// (canonical URL, offset, compressed size, fetch time) is loaded into a hash
+// map, making a lookup one map probe and one read. Appends are serialized;
+// everything else is safe from any thread.
+class PageArchive {
+public:
+    struct Page {
+        std::string url;
+        std::string final_url;
+        std::string content_type;
+        long http_status = 0;
+        gint64 fetched_at = 0;
+        std::string body;
+    };
+
+    explicit PageArchive(const std::string& directory)
+        : data_path(Glib::build_filename(directory, "archive.warc.zst")),
+          index_path(Glib::build_filename(directory, "archive.idx")) {
+        data_file = std::fopen(data_path.c_str(), "a+b");
+        if (!data_file) {
+            g_warning("Failed to open page archive %s: %s", data_path.c_str(), std::strerror(errno));
+            return;
+        }
+        std::fseek(data_file, 0, SEEK_END);
+        data_size = std::ftell(data_file);
+
+        // A record written without its index line (crash between the two)
+        // is simply unreachable; index lines past the data are dropped
+        std::ifstream index(index_path);
+        std::string line;
+        while (std::getline(index, line)) {
+            std::vector<std::string> fields = split_fields(line);
+            if (fields.size() < 4) continue;
+            Location location;
+            location.offset = std::strtoll(fields[1].c_str(), nullptr, 10);
+            location.size = std::strtoll(fields[2].c_str(), nullptr, 10);
+            location.fetched_at = std::strtoll(fields[3].c_str(), nullptr, 10);
+            if (location.offset + location.size <= data_size) {
+                locations[fields[0]] = location;
+            }
+        }
+        index_file = std::fopen(index_path.c_str(), "ab");
+        if (!index_file) {
+            g_warning("Failed to open archive index %s: %s", index_path.c_str(), std::strerror(errno));
+        }
+    }
+
+    ~PageArchive() {
+        if (data_file) {
+            std::fclose(data_file);
+        }
+        if (index_file) {
+            std::fclose(index_file);
+        }
+    }
+
+    bool is_open() const { return data_file && index_file; }
+
+    bool contains(const std::string& url) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return locations.count(canonical_url(url)) > 0;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return locations.size();
+    }
+
+    // Builds the WARC response record for page; compress() turns it into
+    // the frame append() takes
+    static std::string build_record(const Page& page) {
+        GDateTime* date = g_date_time_new_from_unix_utc(page.fetched_at);
+        gchar* date_text = date ? g_date_time_format(date, "%Y-%m-%dT%H:%M:%SZ") : nullptr;
+        std::string http_block = "HTTP/1.1 " + std::to_string(page.http_status) + "\r\n";
+        if (!page.content_type.empty()) {
+            http_block += "Content-Type: " + page.content_type + "\r\n";
+        }
+        http_block += "Content-Length: " + std::to_string(page.body.size()) + "\r\n\r\n";
+
+        // The record names the URL the body was served from, after any
+        // redirects; the index keeps it under the URL that was requested
+        gchar* record_id = g_uuid_string_random();
+        std::string record = "WARC/1.0\r\nWARC-Type: response\r\n";
+        record += "WARC-Record-ID: <urn:uuid:" + std::string(record_id) + ">\r\n";
+        record += "WARC-Target-URI: " + (page.final_url.empty() ? page.url : page.final_url) + "\r\n";
+        record += "WARC-Date: " + std::string(date_text ? date_text : "") + "\r\n";
+        g_free(record_id);
+        record += "Content-Type: application/http; msgtype=response\r\n";
+        record += "Content-Length: " + std::to_string(http_block.size() + page.body.size()) + "\r\n\r\n";
+        record += http_block;
+        record += page.body;
+        record += "\r\n\r\n";
+
+        g_free(date_text);
+        if (date) {
+            g_date_time_unref(date);
+        }
+        return record;
+    }
+
+    // Called on the compression workers, each with its own context
+    static bool compress(ZSTD_CCtx* context, const std::string& record, std::string& frame) {
+        frame.resize(ZSTD_compressBound(record.size()));
+        size_t size = ZSTD_compressCCtx(context, &frame[0], frame.size(), record.data(), record.size(), 9);
+        if (ZSTD_isError(size)) {
+            g_warning("Failed to compress archive record: %s", ZSTD_getErrorName(size));
+            return false;
+        }
+        frame.resize(size);
+        return true;
+    }
+
+    bool append(const std::string& url, const std::string& frame, gint64 fetched_at) {
+        std::string key = canonical_url(url);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!is_open()) return false;
+
+        Location location{data_size, (long long)frame.size(), fetched_at};
+        if (std::fwrite(frame.data(), 1, frame.size(), data_file) != frame.size() || std::fflush(data_file) != 0) {
+            g_warning("Failed to write page archive %s: %s", data_path.c_str(), std::strerror(errno));
+            // Later records must not land after a partial one
+            std::fseek(data_file, 0, SEEK_END);
+            data_size = std::ftell(data_file);
+            return false;
+        }
+        data_size += frame.size();
+
+        std::fprintf(index_file, "%s\t%lld\t%lld\t%lld\n", escape_field(key).c_str(),
+                     location.offset, location.size, (long long)fetched_at);
+        std::fflush(index_file);
+        locations[key] = location;
+        return true;
+    }
+
+    // Reads back the latest record of url
+    bool lookup(const std::string& url, Page& page) {
+        std::string frame;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = locations.find(canonical_url(url));
+            if (found == locations.end() || !data_file) return false;
+            frame.resize(found->second.size);
+            if (std::fseek(data_file, found->second.offset, SEEK_SET) != 0 ||
+                std::fread(&frame[0], 1, frame.size(), data_file) != frame.size()) {
+                g_warning("Failed to read page archive %s", data_path.c_str());
+                std::fseek(data_file, 0, SEEK_END);
+                return false;
+            }
+            std::fseek(data_file, 0, SEEK_END);
+        }
+
+        unsigned long long record_size = ZSTD_getFrameContentSize(frame.data(), frame.size());
+        if (record_size == ZSTD_CONTENTSIZE_ERROR || record_size == ZSTD_CONTENTSIZE_UNKNOWN) return false;
+        std::string record(record_size, '\0');
+        size_t size = ZSTD_decompress(&record[0], record.size(), frame.data(), frame.size());
+        if (ZSTD_isError(size)) {
+            g_warning("Damaged page archive record for %s: %s", url.c_str(), ZSTD_getErrorName(size));
+            return false;
+        }
+        record.resize(size);
+        if (!parse_record(record, page)) return false;
+        page.url = url;
+        return true;
+    }
+
+private:
+    struct Location {
+        long long offset;
+        long long size;
+        gint64 fetched_at;
+    };
+
+    static bool parse_record(const std::string& record, Page& page) {
+        size_t warc_end = record.find("\r\n\r\n");
+        if (record.compare(0, 9, "WARC/1.0\r") != 0 || warc_end == std::string::npos) return false;
+        size_t http_end = record.find("\r\n\r\n", warc_end + 4);
+        if (http_end == std::string::npos) return false;
+
+        auto header = [&record](size_t begin, size_t end, const char* name) {
+            std::string prefix = std::string("\r\n") + name + ": ";
+            size_t start = record.find(prefix, begin);
+            if (start == std::string::npos || start >= end) return std::string();
+            start += prefix.size();
+            return record.substr(start, record.find("\r\n", start) - start);
+        };
+        page.url = header(0, warc_end, "WARC-Target-URI");
+        // Older records named the requested URL and kept the final one here
+        page.final_url = header(0, warc_end, "WARC-Refers-To-Target-URI");
+        if (page.final_url.empty()) {
+            page.final_url = page.url;
+        }
+        page.http_status = std::strtol(record.c_str() + warc_end + 4 + 9, nullptr, 10); // after "HTTP/1.1 "
+        page.content_type = header(warc_end + 2, http_end, "Content-Type");
+        size_t body_size = std::strtoull(header(warc_end + 2, http_end, "Content-Length").c_str(), nullptr, 10);
+        if (http_end + 4 + body_size > record.size()) return false;
+        page.body = record.substr(http_end + 4, body_size);
+        return true;
+    }
+
+    // URLs never contain tabs or newlines once percent-encoded, but the
+    // index must not break on ones that were typed in
+    static std::string escape_field(const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '\t') escaped += "%09";
+            else if (c == '\n') escaped += "%0A";
+            else if (c == '\r') escaped += "%0D";
+            else escaped += c;
+        }
+        return escaped;
+    }
+
+    static std::vector<std::string> split_fields(const std::string& line) {
+        std::vector<std::string> fields;
+        size_t start = 0;
+        while (true) {
+            size_t tab = line.find('\t', start);
+            fields.push_back(line.substr(start, tab - start));
+            if (tab == std::string::npos) break;
+            start = tab + 1;
+        }
+        return fields;
+    }
+
+    std::string data_path;
+    std::string index_path;
+    FILE* data_file = nullptr;
+    FILE* index_file = nullptr;
+    long long data_size = 0;
+    std::mutex mutex;
+    std::unordered_map<std::string, Location> locations;
+};
+
+// Blocking queue with a capacity, for handing work between thread pools.
+// push() waits while it is full, which throttles the producers; after
+// close() pop() drains what is left and then returns false.
+template <typename T>
+class WorkQueue {
+public:
+    explicit WorkQueue(size_t capacity) : capacity(capacity) {}
+
+    bool push(T&& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this]() { return closed || items.size() < capacity; });
+        if (closed) return false;
+        items.push_back(std::move(item));
+        not_empty.notify_one();
+        return true;
+    }
+
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this]() { return closed || !items.empty(); });
+        if (items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+private:
+    size_t capacity;
+    bool closed = false;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+};
+
+// Downloads pages into a PageArchive. Fetch threads download bodies and
+// hand them to a pool of compression threads (one per core), so a slow
+// zstd level never holds up the network and the network never waits for a
+// single compressor. The bounded queue between them caps memory.
+class PageArchiver {
+public:
+    PageArchiver(std::shared_ptr<PageArchive> archive, size_t fetch_threads, guint64 max_page_bytes)
+        : archive(std::move(archive)), max_page_bytes(max_page_bytes), downloads(64) {
+        size_t compress_threads = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < std::max<size_t>(1, fetch_threads); ++i) {
+            fetchers.emplace_back(&PageArchiver::fetch_loop, this);
+        }
+        for (size_t i = 0; i < compress_threads; ++i) {
+            compressors.emplace_back(&PageArchiver::compress_loop, this);
+        }
+    }
+
+    // Stops soon: transfers in flight are aborted and queued URLs dropped;
+    // pages already downloaded are still written
+    ~PageArchiver() {
+        stopping = true;
+        urls.close();
+        for (std::thread& thread : fetchers) {
+            thread.join();
+        }
+        downloads.close();
+        for (std::thread& thread : compressors) {
+            thread.join();
+        }
+    }
+
+    void add(const std::string& url) {
+        queued++;
+        urls.push(std::string(url));
+    }
+
+    // Progress counters, read by the UI
+    long total() const { return queued; }
+    long archived() const { return stored; }
+    long failed() const { return failures; }
+    bool idle() const { return stored + failures == queued; }
+
+private:
+    struct Transfer {
+        PageArchiver* archiver;
+        std::string* body;
+    };
+
+    void fetch_loop() {
+        std::string url;
+        while (urls.pop(url)) {
+            if (stopping) break;
+            PageArchive::Page page;
+            if (fetch(url, page)) {
+                if (!downloads.push(std::move(page))) break;
+            } else {
+                failures++;
+            }
+        }
+    }
+
+    bool fetch(const std::string& url, PageArchive::Page& page) {
+        CURL* curl = curl_easy_init();
+        if (!curl) return false;
+
+        page.url = url.find("://") == std::string::npos ? "http://" + url : url;
+        Transfer transfer{this, &page.body};
+        curl_easy_setopt(curl, CURLOPT_URL, page.url.c_str());
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer);
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, progress_callback);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, this);
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt(curl, CURLOPT_MAXFILESIZE_LARGE, (curl_off_t)max_page_bytes);
+        curl_easy_setopt(curl, CURLOPT_USERAGENT, "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36");
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, ""); // Stored decoded
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L);
+
+        CURLcode res;
+        {
+            TraceSpan span("archive-fetch");
+            res = curl_easy_perform(curl);
+        }
+
+        char* effective_url = nullptr;
+        char* content_type = nullptr;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &page.http_status);
+        curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &effective_url);
+        curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &content_type);
+        page.final_url = effective_url ? effective_url : "";
+        page.content_type = content_type ? content_type : "";
+        page.fetched_at = g_get_real_time() / G_USEC_PER_SEC;
+        curl_easy_cleanup(curl);
+        return res == CURLE_OK && page.http_status >= 200 && page.http_status < 300;
+    }
+
+    void compress_loop() {
+        ZSTD_CCtx* context = ZSTD_createCCtx();
+        PageArchive::Page page;
+        std::string frame;
+        while (downloads.pop(page)) {
+            bool ok = false;
+            if (context) {
+                TraceSpan span("archive-compress");
+                ok = PageArchive::compress(context, PageArchive::build_record(page), frame) &&
+                     archive->append(page.url, frame, page.fetched_at);
+            }
+            (ok ? stored : failures)++;
+        }
+        ZSTD_freeCCtx(context);
+    }
+
+    static size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
+        Transfer* transfer = (Transfer*)userp;
+        // Servers that send no Content-Length are cut off here instead
+        if (transfer->archiver->stopping || transfer->body->size() + size * nmemb > transfer->archiver->max_page_bytes) {
+            return 0;
+        }
+        transfer->body->append((char*)contents, size * nmemb);
+        return size * nmemb;
+    }
+
+    static int progress_callback(void* userp, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+        return ((PageArchiver*)userp)->stopping ? 1 : 0;
+    }
+
+    std::shared_ptr<PageArchive> archive;
+    guint64 max_page_bytes;
+    std::atomic<bool> stopping{false};
+    std::atomic<long> queued{0};
+    std::atomic<long> stored{0};
+    std::atomic<long> failures{0};
+    WorkQueue<std::string> urls{SIZE_MAX};
+    WorkQueue<PageArchive::Page> downloads;
+    std::vector<std::thread> fetchers;
+    std::vector<std::thread> compressors;
+};
+
+// A bookmark read from a browser export. icon holds raw image bytes
+// (PNG/ICO/...) when the export carried one.
+struct ImportedEntry {
+    std::string title;
+    std::string url;
+    std::string icon;
+};
+
+using ImportCallback = std::function<void(ImportedEntry&&)>;
+
+// Decodes the entities that show up in bookmark titles (&amp;, &#39;, ...)
+inline std::string decode_html_entities(const std::string& text) {
+    if (text.find('&') == std::string::npos) return text;
+
+    std::string decoded;
+    decoded.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        size_t end = text[i] == '&' ? text.find(';', i) : std::string::npos;
+        if (end == std::string::npos || end - i > 10) {
+            decoded += text[i];
+            continue;
+        }
+
+        std::string entity = text.substr(i + 1, end - i - 1);
+        unsigned long code = 0;
+        if (entity == "amp") code = '&';
+        else if (entity == "lt") code = '<';
+        else if (entity == "gt") code = '>';
+        else if (entity == "quot") code = '"';
+        else if (entity == "apos") code = '\'';
+        else if (entity == "nbsp") code = 0xA0;
+        else if (entity.size() > 1 && entity[0] == '#') {
+            bool hex = entity[1] == 'x' || entity[1] == 'X';
+            code = std::strtoul(entity.c_str() + (hex ? 2 : 1), nullptr, hex ? 16 : 10);
+        }
+
+        if (code == 0 || code > 0x10FFFF) {
+            decoded += text[i];
+            continue;
+        }
+        char utf8[8];
+        int length = g_unichar_to_utf8((gunichar)code, utf8);
+        decoded.append(utf8, length);
+        i = end;
+    }
+    return decoded;
+}
+
+// Streaming reader for the Netscape bookmark file format exported by every
+// browser: only <A HREF=... ICON=...>title</A> elements are picked out, so
+// memory stays bounded by the largest single element.
+class NetscapeBookmarkParser {
+public:
+    void feed(const char* data, size_t size, const ImportCallback& emit) {
+        pending.append(data, size);
+
+        while (true) {
+            size_t tag_start = find_ci(pending, "<a ", offset);
+            if (tag_start == std::string::npos) {
+                // Keep a tail in case "<a " straddles the chunk boundary
+                offset = pending.size() > 2 ? pending.size() - 2 : 0;
+                break;
+            }
+
+            size_t tag_end = find_tag_end(tag_start);
+            size_t close = tag_end == std::string::npos ? std::string::npos : find_ci(pending, "</a>", tag_end);
+            if (close == std::string::npos) {
+                // A link that never ends (malformed file) would otherwise
+                // be searched again with every chunk and kept forever
+                if (pending.size() - tag_start > max_link_size) {
+                    offset = tag_start + 3;
+                    continue;
+                }
+                offset = tag_start;
+                break;
+            }
+
+            std::string tag = pending.substr(tag_start, tag_end - tag_start);
+            ImportedEntry entry;
+            entry.url = decode_html_entities(attribute(tag, "href"));
+            entry.title = decode_html_entities(trim(pending.substr(tag_end + 1, close - tag_end - 1)));
+            entry.icon = decode_data_uri(attribute(tag, "icon"));
+            if (!entry.url.empty() && entry.url.compare(0, 11, "javascript:") != 0) {
+                emit(std::move(entry));
+            }
+            offset = close + 4;
+        }
+
+        // Drop consumed text once it dominates the buffer
+        if (offset > 65536 && offset * 2 > pending.size()) {
+            pending.erase(0, offset);
+            offset = 0;
+        }
+    }
+
+private:
+    // Longest <a ...>title</a> waited for; ICON data URIs make up most of it
+    static const size_t max_link_size = 256 * 1024;
+
+    static size_t find_ci(const std::string& haystack, const char* needle, size_t from) {
+        size_t length = std::strlen(needle);
+        for (size_t i = from; i + length <= haystack.size(); ++i) {
+            if (g_ascii_strncasecmp(haystack.c_str() + i, needle, length) == 0) {
+                return i;
+            }
+        }
+        return std::string::npos;
+    }
+
+    // Position of the '>' closing the tag, skipping quoted attribute values
+    size_t find_tag_end(size_t tag_start) const {
+        char quote = 0;
+        for (size_t i = tag_start; i < pending.size(); ++i) {
+            char c = pending[i];
+            if (quote) {
+                if (c == quote) quote = 0;
+            } else if (c == '"' || c == '\'') {
+                quote = c;
+            } else if (c == '>') {
+                return i;
+            }
+        }
+        return std::string::npos;
+    }
+
+    static std::string attribute(const std::string& tag, const char* name) {
+        size_t length = std::strlen(name);
+        for (size_t i = find_ci(tag, name, 0); i != std::string::npos; i = find_ci(tag, name, i + 1)) {
+            // Must be a whole attribute name followed by '='
+            if (!g_ascii_isspace(tag[i - 1])) continue;
+            size_t equals = tag.find_first_not_of(" \t\r\n", i + length);
+            if (equals == std::string::npos || tag[equals] != '=') continue;
+            size_t value_start = tag.find_first_not_of(" \t\r\n", equals + 1);
+            if (value_start == std::string::npos) return std::string();
+
+            char quote = tag[value_start];
+            if (quote == '"' || quote == '\'') {
+                size_t value_end = tag.find(quote, value_start + 1);
+                return tag.substr(value_start + 1, value_end == std::string::npos ? std::string::npos : value_end - value_start - 1);
+            }
+            size_t value_end = tag.find_first_of(" \t\r\n", value_start);
+            return tag.substr(value_start, value_end == std::string::npos ? std::string::npos : value_end - value_start);
+        }
+        return std::string();
+    }
+
+    static std::string decode_data_uri(const std::string& uri) {
+        size_t comma = uri.find(',');
+        if (uri.compare(0, 5, "data:") != 0 || comma == std::string::npos ||
+            uri.rfind(";base64", comma) == std::string::npos) {
+            return std::string();
+        }
+        gsize length = 0;
+        guchar* bytes = g_base64_decode(uri.c_str() + comma + 1, &length);
+        std::string icon((const char*)bytes, length);
+        g_free(bytes);
+        return icon;
+    }
+
+    static std::string trim(std::string text) {
+        text.erase(0, text.find_first_not_of(" \t\n\r"));
+        text.erase(text.find_last_not_of(" \t\n\r") + 1);
+        return text;
+    }
+
+    std::string pending;
+    size_t offset = 0;
+};
+
+// Streaming reader for Chromium's "Bookmarks" JSON. Rather than building a
+// tree, it tracks the keys of the objects currently open and emits every
+// object with "type": "url" as it closes.
+class ChromiumBookmarkParser {
+public:
+    void feed(const char* data, size_t size, const ImportCallback& emit) {
+        for (size_t i = 0; i < size; ++i) {
+            char c = data[i];
+            if (in_string) {
+                string_char(c);
+                continue;
+            }
+
+            switch (c) {
+                case '{':
+                    stack.push_back(Frame{true});
+                    break;
+                case '[':
+                    stack.push_back(Frame{false});
+                    break;
+                case '}':
+                case ']':
+                    if (!stack.empty()) {
+                        Frame frame = std::move(stack.back());
+                        stack.pop_back();
+                        if (frame.object && frame.type == "url" && !frame.url.empty()) {
+                            ImportedEntry entry;
+                            entry.title = std::move(frame.name);
+                            entry.url = std::move(frame.url);
+                            emit(std::move(entry));
+                        }
+                    }
+                    break;
+                case '"':
+                    in_string = true;
+                    string_is_key = !stack.empty() && stack.back().object && stack.back().expect_key;
+                    value.clear();
+                    break;
+                case ':':
+                    if (!stack.empty()) stack.back().expect_key = false;
+                    break;
+                case ',':
+                    if (!stack.empty() && stack.back().object) {
+                        stack.back().expect_key = true;
+                        stack.back().key.clear();
+                    }
+                    break;
+                default:
+                    // Whitespace, numbers, true/false/null carry nothing we need
+                    break;
+            }
+        }
+    }
+
+private:
+    struct Frame {
+        bool object;
+        bool expect_key = true;
+        std::string key;
+        std::string type;
+        std::string name;
+        std::string url;
+    };
+
+    void string_char(char c) {
+        if (unicode_digits >= 0) {
+            unicode_value = unicode_value * 16 + g_ascii_xdigit_value(c);
+            if (++unicode_digits == 4) {
+                unicode_digits = -1;
+                append_code_point(unicode_value);
+            }
+            return;
+        }
+        if (escape) {
+            escape = false;
+            switch (c) {
+                case 'n': value += '\n'; break;
+                case 't': value += '\t'; break;
+                case 'r': value += '\r'; break;
+                case 'b': value += '\b'; break;
+                case 'f': value += '\f'; break;
+                case 'u': unicode_digits = 0; unicode_value = 0; break;
+                default: value += c; break; // \" \\ \/
+            }
+            return;
+        }
+        if (c == '\\') {
+            escape = true;
+        } else if (c == '"') {
+            in_string = false;
+            string_done();
+        } else {
+            value += c;
+        }
+    }
+
+    void append_code_point(unsigned code) {
+        if (code >= 0xD800 && code <= 0xDBFF) {
+            high_surrogate = code;
+            return;
+        }
+        if (code >= 0xDC00 && code <= 0xDFFF && high_surrogate) {
+            code = 0x10000 + ((high_surrogate - 0xD800) << 10) + (code - 0xDC00);
+        }
+        high_surrogate = 0;
+        char utf8[8];
+        value.append(utf8, g_unichar_to_utf8((gunichar)code, utf8));
+    }
+
+    void string_done() {
+        if (stack.empty() || !stack.back().object) return;
+        Frame& frame = stack.back();
+        if (string_is_key) {
+            frame.key = value;
+        } else if (frame.key == "type") {
+            frame.type = value;
+        } else if (frame.key == "name") {
+            frame.name = value;
+        } else if (frame.key == "url") {
+            frame.url = value;
+        }
+    }
+
+    std::vector<Frame> stack;
+    std::string value;
+    bool in_string = false;
+    bool string_is_key = false;
+    bool escape = false;
+    int unicode_digits = -1;
+    unsigned unicode_value = 0;
+    unsigned high_surrogate = 0;
+};
+
+// Looks up favicons in a browser's icon database (Chromium "Favicons",
+// Firefox "favicons.sqlite") next to the bookmark file, if there is one.
+class BrowserIconLookup {
+public:
+    BrowserIconLookup(const std::string& path, const char* query) {
+        // immutable=1 reads the file even while the browser holds its lock
+        std::string uri = "file:" + path + "?immutable=1";
+        if (!Glib::file_test(path, Glib::FILE_TEST_IS_REGULAR) ||
+            sqlite3_open_v2(uri.c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_URI, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(db, query, -1, &stmt, nullptr) != SQLITE_OK) {
+            close();
+        }
+    }
+
+    ~BrowserIconLookup() { close(); }
+
+    std::string find(const std::string& url) {
+        std::string icon;
+        if (!stmt) return icon;
+        sqlite3_bind_text(stmt, 1, url.data(), url.size(), SQLITE_STATIC);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char* data = (const char*)sqlite3_column_blob(stmt, 0);
+            icon.assign(data ? data : "", sqlite3_column_bytes(stmt, 0));
+        }
+        sqlite3_reset(stmt);
+        return icon;
+    }
+
+private:
+    void close() {
+        sqlite3_finalize(stmt);
+        stmt = nullptr;
+        sqlite3_close(db);
+        db = nullptr;
+    }
+
+    sqlite3* db = nullptr;
+    sqlite3_stmt* stmt = nullptr;
+};
+
+// Reads a bookmark export (Netscape HTML, Chromium JSON or Firefox
+// places.sqlite, told apart by content) and hands entries to emit as they
+// are parsed. Runs on a worker thread.
+inline bool import_bookmarks(const std::string& path, const ImportCallback& emit, std::string& error) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        error = "Cannot open " + path;
+        return false;
+    }
+
+    std::vector<char> chunk(256 * 1024);
+    size_t length = std::fread(chunk.data(), 1, chunk.size(), file);
+    std::string dir = Glib::path_get_dirname(path);
+
+    // Firefox: query the database instead of reading it as text
+    if (length >= 16 && std::memcmp(chunk.data(), "SQLite format 3", 16) == 0) {
+        std::fclose(file);
+        sqlite3* db = nullptr;
+        sqlite3_stmt* stmt = nullptr;
+        std::string uri = "file:" + path + "?immutable=1";
+        if (sqlite3_open_v2(uri.c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_URI, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(db,
+                "SELECT p.url, b.title FROM moz_bookmarks b JOIN moz_places p ON p.id = b.fk "
+                "WHERE b.type = 1 AND p.url NOT LIKE 'place:%' ORDER BY b.parent, b.position",
+                -1, &stmt, nullptr) != SQLITE_OK) {
+            error = "Not a Firefox places database: " + std::string(sqlite3_errmsg(db));
+            sqlite3_close(db);
+            return false;
+        }
+
+        BrowserIconLookup icons(Glib::build_filename(dir, "favicons.sqlite"),
+            "SELECT i.data FROM moz_pages_w_icons p "
+            "JOIN moz_icons_to_pages ip ON ip.page_id = p.id JOIN moz_icons i ON i.id = ip.icon_id "
+            "WHERE p.page_url = ? ORDER BY i.width LIMIT 1");
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            ImportedEntry entry;
+            const char* url = (const char*)sqlite3_column_text(stmt, 0);
+            const char* title = (const char*)sqlite3_column_text(stmt, 1);
+            entry.url = url ? url : "";
+            entry.title = title ? title : "";
+            entry.icon = icons.find(entry.url);
+            emit(std::move(entry));
+        }
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+        return true;
+    }
+
+    size_t first = 0;
+    while (first < length && g_ascii_isspace(chunk[first])) first++;
+    bool json = first < length && chunk[first] == '{';
+
+    NetscapeBookmarkParser html_parser;
+    ChromiumBookmarkParser json_parser;
+    BrowserIconLookup icons(json ? Glib::build_filename(dir, "Favicons") : std::string(),
+        "SELECT b.image_data FROM icon_mapping m JOIN favicon_bitmaps b ON b.icon_id = m.icon_id "
+        "WHERE m.page_url = ? ORDER BY b.width LIMIT 1");
+    ImportCallback with_icon = [&icons, &emit](ImportedEntry&& entry) {
+        entry.icon = icons.find(entry.url);
+        emit(std::move(entry));
+    };
+
+    while (length > 0) {
+        if (json) {
+            json_parser.feed(chunk.data(), length, with_icon);
+        } else {
+            html_parser.feed(chunk.data(), length, emit);
+        }
+        length = std::fread(chunk.data(), 1, chunk.size(), file);
+    }
+    std::fclose(file);
+    return true;
+}
+
+enum ExportFormat {
+    EXPORT_MODE2 = 0,
+    EXPORT_MODE1 = 1,
+    EXPORT_NETSCAPE_HTML = 2,
+    EXPORT_JSON_LINES = 3,
+    EXPORT_CSV = 4
+};
+
+// One row as handed to the exporter. The exporter never keeps it, so the
+// caller can refill the same object for every row. icon_uri points at a
+// shared data: URI, or is null when the row has no icon.
+struct ExportedEntry {
+    std::string title;
+    std::string url;
+    FetchStatus status = FETCH_PENDING;
+    std::string final_url;
+    const std::string* icon_uri = nullptr;
+};
+
+// Writes rows straight to a FILE* as they are handed over; escaping is done
+// run by run into the stdio buffer, so memory use does not grow with the
+// size of the list.
+class BookmarkExporter {
+public:
+    BookmarkExporter(FILE* file, ExportFormat format, bool metadata)
+        : file(file), format(format), metadata(metadata) {}
+
+    void begin() {
+        if (format == EXPORT_NETSCAPE_HTML) {
+            put("<!DOCTYPE NETSCAPE-Bookmark-file-1>\n"
+                "<META HTTP-EQUIV=\"Content-Type\" CONTENT=\"text/html; charset=UTF-8\">\n"
+                "<TITLE>Bookmarks</TITLE>\n"
+                "<H1>Bookmarks</H1>\n"
+                "<DL><p>\n");
+        } else if (format == EXPORT_CSV) {
+            put(metadata ? "title,url,status,final_url,icon\r\n" : "title,url\r\n");
+        }
+    }
+
+    void write(const ExportedEntry& entry) {
+        switch (format) {
+        case EXPORT_MODE2:
+            put(format_mode2_line(entry.title, entry.url));
+            put("\n");
+            break;
+
+        case EXPORT_MODE1:
+            put(entry.title.empty() ? entry.url : entry.title);
+            put("\n");
+            put(entry.url);
+            put("\n\n");
+            break;
+
+        case EXPORT_NETSCAPE_HTML:
+            put("    <DT><A HREF=\"");
+            put_html(entry.url);
+            put("\"");
+            if (metadata && entry.icon_uri) {
+                put(" ICON=\"");
+                put(*entry.icon_uri);
+                put("\"");
+            }
+            put(">");
+            put_html(entry.title);
+            put("</A>\n");
+            break;
+
+        case EXPORT_JSON_LINES:
+            put("{\"title\":");
+            put_json(entry.title);
+            put(",\"url\":");
+            put_json(entry.url);
+            if (metadata) {
+                put(",\"status\":\"");
+                put(status_name(entry.status));
+                put("\",\"final_url\":");
+                put_json(entry.final_url);
+                put(",\"icon\":");
+                if (entry.icon_uri) {
+                    put_json(*entry.icon_uri);
+                } else {
+                    put("null");
+                }
+            }
+            put("}\n");
+            break;
+
+        case EXPORT_CSV:
+            put_csv(entry.title);
+            put(",");
+            put_csv(entry.url);
+            if (metadata) {
+                put(",");
+                put(status_name(entry.status));
+                put(",");
+                put_csv(entry.final_url);
+                put(",");
+                if (entry.icon_uri) put_csv(*entry.icon_uri);
+            }
+            put("\r\n");
+            break;
+        }
+    }
+
+    // Returns false if anything failed to write
+    bool finish() {
+        if (format == EXPORT_NETSCAPE_HTML) {
+            put("</DL><p>\n");
+        }
+        return std::fflush(file) == 0 && !std::ferror(file);
+    }
+
+    static const char* status_name(FetchStatus status) {
+        switch (status) {
+        case FETCH_DONE: return "done";
+        case FETCH_FAILED: return "failed";
+        default: return "pending";
+        }
+    }
+
+private:
+    void put(const char* text) { std::fputs(text, file); }
+    void put(const char* data, size_t size) { std::fwrite(data, 1, size, file); }
+    void put(const std::string& text) { put(text.data(), text.size()); }
+
+    // Writes text with the characters named by escape() replaced; the
+    // unescaped runs in between go out in one fwrite each
+    template <typename Escape>
+    void put_escaped(const std::string& text, Escape escape) {
+        size_t run_start = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            char buffer[8];
+            const char* replacement = escape((unsigned char)text[i], buffer);
+            if (!replacement) continue;
+            put(text.data() + run_start, i - run_start);
+            put(replacement);
+            run_start = i + 1;
+        }
+        put(text.data() + run_start, text.size() - run_start);
+    }
+
+    void put_html(const std::string& text) {
+        put_escaped(text, [](unsigned char c, char*) -> const char* {
+            switch (c) {
+            case '&': return "&amp;";
+            case '<': return "&lt;";
+            case '>': return "&gt;";
+            case '"': return "&quot;";
+            default: return nullptr;
+            }
+        });
+    }
+
+    void put_json(const std::string& text) {
+        put("\"");
+        put_escaped(text, [](unsigned char c, char* buffer) -> const char* {
+            switch (c) {
+            case '"': return "\\\"";
+            case '\\': return "\\\\";
+            case '\n': return "\\n";
+            case '\r': return "\\r";
+            case '\t': return "\\t";
+            default:
+                if (c >= 0x20) return nullptr;
+                std::snprintf(buffer, 8, "\\u%04x", c);
+                return buffer;
+            }
+        });
+        put("\"");
+    }
+
+    // RFC 4180: quote fields holding separators, quotes or line breaks
+    void put_csv(const std::string& text) {
+        if (text.find_first_of(",\"\r\n") == std::string::npos) {
+            put(text);
+            return;
+        }
+        put("\"");
+        put_escaped(text, [](unsigned char c, char*) -> const char* {
+            return c == '"' ? "\"\"" : nullptr;
+        });
+        put("\"");
+    }
+
+    FILE* file;
+    ExportFormat format;
+    bool metadata;
+};
+
+// Bounded lock-free queue for many producer threads and a single consumer
+// (Vyukov's array queue). Each cell carries a sequence number telling
+// producers and the consumer whose turn it is, so neither side takes a lock.
+template <typename T>
+class BoundedMpscQueue {
+public:
+    explicit BoundedMpscQueue(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Returns false without taking value when the queue is full
+    bool try_push(T&& value) {
+        size_t position = enqueue_position.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+            if (difference == 0) {
+                if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Waits while the queue is full, which holds fetch threads back when
+    // the UI falls behind
+    void push(T&& value) {
+        while (!try_push(std::move(value))) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // Consumer thread only
+    bool pop(T& value) {
+        Cell& cell = cells[dequeue_position & mask];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (sequence != dequeue_position + 1) return false;
+        value = std::move(cell.value);
+        cell.value = T();
+        cell.sequence.store(dequeue_position + mask + 1, std::memory_order_release);
+        dequeue_position++;
+        return true;
+    }
+
+    // Consumer thread only
+    bool empty() const {
+        return cells[dequeue_position & mask].sequence.load(std::memory_order_acquire) != dequeue_position + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> enqueue_position{0};
+    alignas(64) size_t dequeue_position = 0;
+};
+
+// Orders pending row fetches: the selected row first, then rows inside the
+// viewport (top to bottom), then everything else in list order.
+class FetchScheduler {
+public:
+    enum Priority { PRIORITY_LOW = 0, PRIORITY_VISIBLE = 1, PRIORITY_SELECTED = 2 };
+
+    void reset(const std::vector<int>& row_ids) {
+        queue.clear();
+        entries.clear();
+        visible_ids.clear();
+        selected_id = -1;
+        next_order = 0;
+        for (int row_id : row_ids) {
+            add(row_id);
+        }
+    }
+
+    // Queues a row behind everything already in list order
+    void add(int row_id) {
+        if (entries.count(row_id)) return;
+        Entry entry{PRIORITY_LOW, next_order, next_order};
+        next_order++;
+        entries[row_id] = entry;
+        queue.insert(Key{-PRIORITY_LOW, entry.order, row_id});
+    }
+
+    // Rows currently in the viewport are promoted; rows that scrolled away
+    // fall back to their place in list order.
+    void set_visible(const std::vector<int>& row_ids) {
+        std::unordered_set<int> now_visible(row_ids.begin(), row_ids.end());
+        for (int id : visible_ids) {
+            if (!now_visible.count(id)) {
+                reprioritize(id, PRIORITY_LOW, -1);
+            }
+        }
+        for (size_t i = 0; i < row_ids.size(); ++i) {
+            reprioritize(row_ids[i], PRIORITY_VISIBLE, (long)i);
+        }
+        visible_ids = row_ids;
+    }
+
+    void set_selected(int row_id) {
+        if (row_id == selected_id) return;
+        if (selected_id >= 0) {
+            bool visible = std::find(visible_ids.begin(), visible_ids.end(), selected_id) != visible_ids.end();
+            reprioritize(selected_id, visible ? PRIORITY_VISIBLE : PRIORITY_LOW, -1, true);
+        }
+        selected_id = row_id;
+        if (row_id >= 0) {
+            reprioritize(row_id, PRIORITY_SELECTED, 0);
+        }
+    }
+
+    bool next(int& row_id) {
+        if (queue.empty()) return false;
+        Key key = *queue.begin();
+        queue.erase(queue.begin());
+        entries.erase(key.row_id);
+        row_id = key.row_id;
+        return true;
+    }
+
+    // Returns false when the row was not queued
+    bool remove(int row_id) {
+        auto it = entries.find(row_id);
+        if (it == entries.end()) return false;
+        queue.erase(Key{-it->second.priority, it->second.order, row_id});
+        entries.erase(it);
+        return true;
+    }
+
+    bool empty() const { return queue.empty(); }
+    size_t size() const { return queue.size(); }
+
+private:
+    struct Entry {
+        int priority;
+        long order;      // position used for ordering within the priority tier
+        long list_order; // position in the list when the fetch started
+    };
+
+    struct Key {
+        int neg_priority;
+        long order;
+        int row_id;
+        bool operator<(const Key& other) const {
+            if (neg_priority != other.neg_priority) return neg_priority < other.neg_priority;
+            if (order != other.order) return order < other.order;
+            return row_id < other.row_id;
+        }
+    };
+
+    // order < 0 means "use the row's list order". A selected row is only
+    // demoted when force is set, so scrolling never steals its slot.
+    void reprioritize(int row_id, int priority, long order, bool force = false) {
+        auto it = entries.find(row_id);
+        if (it == entries.end()) return;
+        Entry& entry = it->second;
+        if (entry.priority == PRIORITY_SELECTED && !force) return;
+        if (order < 0) order = entry.list_order;
+        queue.erase(Key{-entry.priority, entry.order, row_id});
+        entry.priority = priority;
+        entry.order = order;
+        queue.insert(Key{-entry.priority, entry.order, row_id});
+    }
+
+    std::set<Key> queue;
+    std::unordered_map<int, Entry> entries;
+    std::vector<int> visible_ids;
+    int selected_id = -1;
+    long next_order = 0;
+};
+
+// User settings read from ~/.config/url-editor/settings.ini. The app never
+// writes the file; missing or malformed keys keep their defaults.
+struct AppSettings {
+    // Favicon responses larger than this are abandoned ([fetch] max_icon_bytes)
+    guint64 max_icon_bytes = 256 * 1024;
+
+    // Browser program and arguments; URLs are appended as extra arguments.
+    // Empty means the desktop's default browser. ([browser] command)
+    std::string browser_command;
+    // URLs handed to one browser launch, and the pause between launches
+    // ([browser] batch_size, batch_interval_ms)
+    guint64 browser_batch_size = 20;
+    guint64 browser_batch_interval_ms = 1000;
+    // Cached page titles older than this are revalidated ([cache] title_ttl_hours)
+    guint64 title_ttl_hours = 24 * 7;
+    // Parallel downloads when archiving pages, and the largest page kept
+    // ([archive] fetch_concurrency, max_page_bytes)
+    guint64 archive_fetch_concurrency = 8;
+    guint64 archive_max_page_bytes = 16 * 1024 * 1024;
+
+    static std::string path() {
+        return Glib::build_filename(Glib::get_user_config_dir(), "url-editor", "settings.ini");
+    }
+
+    void load() {
+        Glib::KeyFile key_file;
+        try {
+            if (!key_file.load_from_file(path())) return;
+        } catch (const Glib::Error&) {
+            return;
+        }
+        read_uint64(key_file, "fetch", "max_icon_bytes", max_icon_bytes);
+        read_string(key_file, "browser", "command", browser_command);
+        read_uint64(key_file, "browser", "batch_size", browser_batch_size);
+        read_uint64(key_file, "browser", "batch_interval_ms", browser_batch_interval_ms);
+        read_uint64(key_file, "cache", "title_ttl_hours", title_ttl_hours);
+        read_uint64(key_file, "archive", "fetch_concurrency", archive_fetch_concurrency);
+        read_uint64(key_file, "archive", "max_page_bytes", archive_max_page_bytes);
+        if (browser_batch_size == 0) {
+            browser_batch_size = 1;
+        }
+    }
+
+private:
+    static void read_string(Glib::KeyFile& key_file, const char* group, const char* key, std::string& value) {
+        try {
+            value = key_file.get_string(group, key);
+        } catch (const Glib::Error&) {
+            // Keep the default
+        }
+    }
+
+    static void read_uint64(Glib::KeyFile& key_file, const char* group, const char* key, guint64& value) {
+        try {
+            value = key_file.get_uint64(group, key);
+        } catch (const Glib::Error&) {
+            // Keep the default
+        }
+    }
+};
+
+// Decodes a favicon response while it downloads. The first bytes are
+// checked (status code, image signature, Content-Type) before anything is
+// handed to the pixbuf loader, so an HTML error page is dropped after one
+// chunk and an oversized body after max_bytes.
+class IconStreamDecoder {
+public:
+    IconStreamDecoder(CURL* curl, guint64 max_bytes) : curl(curl), max_bytes(max_bytes) {}
+
+    ~IconStreamDecoder() {
+        if (loader) {
+            if (!closed) {
+                gdk_pixbuf_loader_close(loader, nullptr);
+            }
+            g_object_unref(loader);
+        }
+    }
+
+    // Returns false to abort the transfer
+    bool write(const char* data, size_t size) {
+        if (rejected) return false;
+        received += size;
+        if (received > max_bytes) return reject();
+        if (accepted) return feed(data, size);
+
+        head.append(data, size);
+        if (head.size() < sniff_size) return true;
+        if (!sniff()) return reject();
+        accepted = true;
+        bool ok = feed(head.data(), head.size());
+        std::string().swap(head);
+        return ok;
+    }
+
+    // The decoded icon, or null if the response was not a usable image
+    Glib::RefPtr<Gdk::Pixbuf> finish() {
+        Glib::RefPtr<Gdk::Pixbuf> pixbuf;
+        if (rejected) return pixbuf;
+        if (!accepted) {
+            // Bodies shorter than sniff_size end up here
+            if (head.empty() || !sniff() || !feed(head.data(), head.size())) return pixbuf;
+        }
+
+        GError* error = nullptr;
+        closed = true;
+        if (gdk_pixbuf_loader_close(loader, &error)) {
+            GdkPixbuf* pixbuf_c = gdk_pixbuf_loader_get_pixbuf(loader);
+            if (pixbuf_c) {
+                // The loader owns the pixbuf, so take our own reference
+                pixbuf = Glib::wrap(pixbuf_c, true);
+            }
+        }
+        if (error) {
+            g_error_free(error);
+        }
+        return pixbuf;
+    }
+
+    guint64 get_received() const { return received; }
+
+    static size_t on_curl_write(void* contents, size_t size, size_t nmemb, void* userp) {
+        IconStreamDecoder* decoder = (IconStreamDecoder*)userp;
+        return decoder->write((const char*)contents, size * nmemb) ? size * nmemb : 0;
+    }
+
+    // Keeps the Content-Type of the last response (redirects send several)
+    static size_t on_curl_header(char* buffer, size_t size, size_t nitems, void* userp) {
+        IconStreamDecoder* decoder = (IconStreamDecoder*)userp;
+        size_t length = size * nitems;
+        if (length >= 5 && g_ascii_strncasecmp(buffer, "HTTP/", 5) == 0) {
+            decoder->content_type.clear();
+        } else if (length > 13 && g_ascii_strncasecmp(buffer, "content-type:", 13) == 0) {
+            std::string value(buffer + 13, length - 13);
+            value.erase(0, value.find_first_not_of(" \t"));
+            value.erase(value.find_last_not_of(" \t\r\n") + 1);
+            decoder->content_type = value;
+        }
+        return length;
+    }
+
+private:
+    static const size_t sniff_size = 16;
+
+    bool sniff() const {
+        long response_code = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+        if (response_code != 200) return false;
+
+        const unsigned char* bytes = (const unsigned char*)head.data();
+        size_t size = head.size();
+        auto starts_with = [bytes, size](const char* magic, size_t length, size_t offset = 0) {
+            return size >= offset + length && std::memcmp(bytes + offset, magic, length) == 0;
+        };
+        if (starts_with("\x89PNG", 4) ||                              // PNG
+            starts_with("\0\0\1\0", 4) || starts_with("\0\0\2\0", 4) || // ICO, CUR
+            starts_with("GIF8", 4) ||
+            starts_with("\xFF\xD8\xFF", 3) ||                          // JPEG
+            starts_with("BM", 2) ||
+            (starts_with("RIFF", 4) && starts_with("WEBP", 4, 8)) ||
+            starts_with("<svg", 4)) {
+            return true;
+        }
+
+        // No known signature: trust an explicit image type (SVG with an XML
+        // prolog, formats only a pixbuf module knows), reject everything else
+        return g_ascii_strncasecmp(content_type.c_str(), "image/", 6) == 0;
+    }
+
+    bool feed(const char* data, size_t size) {
+        if (!loader) {
+            loader = gdk_pixbuf_loader_new();
+            if (!loader) return reject();
+        }
+        GError* error = nullptr;
+        if (!gdk_pixbuf_loader_write(loader, (const guint8*)data, size, &error)) {
+            if (error) {
+                g_error_free(error);
+            }
+            return reject();
+        }
+        return true;
+    }
+
+    bool reject() {
+        rejected = true;
+        return false;
+    }
+
+    CURL* curl;
+    guint64 max_bytes;
+    guint64 received = 0;
+    std::string head;
+    std::string content_type;
+    GdkPixbufLoader* loader = nullptr;
+    bool accepted = false;
+    bool rejected = false;
+    bool closed = false;
+};
+
+// Append-only string storage. Strings are copied back to back into 1 MiB
+// blocks that never move, and referenced by a 32-bit position (block and
+// offset) plus length. A string larger than a block gets a block of its own.
+class StringArena {
+public:
+    struct Ref {
+        uint32_t position = 0;
+        uint32_t length = 0;
+    };
+
+    Ref add(const char* data, size_t size) {
+        Ref ref;
+        if (size == 0) return ref;
+
+        if (size > block_size) {
+            check_block_limit();
+            blocks.emplace_back(new char[size]);
+            capacity += size;
+            std::memcpy(blocks.back().get(), data, size);
+            ref.position = (uint32_t)(blocks.size() - 1) << offset_bits;
+        } else {
+            if (blocks.empty() || current_used + size > block_size || current_block != blocks.size() - 1) {
+                check_block_limit();
+                blocks.emplace_back(new char[block_size]);
+                capacity += block_size;
+                current_block = blocks.size() - 1;
+                current_used = 0;
+            }
+            std::memcpy(blocks[current_block].get() + current_used, data, size);
+            ref.position = (uint32_t)(current_block << offset_bits) | (uint32_t)current_used;
+            current_used += size;
+        }
+        ref.length = (uint32_t)size;
+        used += size;
+        return ref;
+    }
+
+    Ref add(const std::string& text) { return add(text.data(), text.size()); }
+
+    const char* data(Ref ref) const {
+        if (ref.length == 0) return "";
+        return blocks[ref.position >> offset_bits].get() + (ref.position & offset_mask);
+    }
+
+    std::string get(Ref ref) const { return std::string(data(ref), ref.length); }
+
+    // The string is no longer referenced. Its space is only reclaimed by
+    // copying the live strings into a new arena.
+    void release(Ref ref) { wasted += ref.length; }
+
+    size_t capacity_bytes() const { return capacity + blocks.capacity() * sizeof(blocks[0]); }
+    size_t used_bytes() const { return used; }
+    size_t wasted_bytes() const { return wasted; }
+
+private:
+    static const uint32_t offset_bits = 20;
+    static const uint32_t offset_mask = (1u << offset_bits) - 1;
+    static const size_t block_size = (size_t)1 << offset_bits;
+    static const size_t max_blocks = (size_t)1 << (32 - offset_bits);
+
+    // A Ref has room for 4096 block numbers; going past that would make
+    // new strings alias old ones
+    void check_block_limit() const {
+        if (blocks.size() >= max_blocks) {
+            g_error("String arena full: %zu blocks of %zu bytes", blocks.size(), block_size);
+        }
+    }
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    size_t current_block = 0;
+    size_t current_used = 0;
+    size_t capacity = 0;
+    size_t used = 0;
+    size_t wasted = 0;
+};
+
+// Gives each distinct string a dense 32-bit id. Id 0 is the empty string.
+class InternTable {
+public:
+    InternTable() { refs.push_back(StringArena::Ref()); }
+
+    uint32_t intern(const char* data, size_t size) {
+        if (size == 0) return 0;
+        auto found = ids.find(std::string_view(data, size));
+        if (found != ids.end()) return found->second;
+
+        StringArena::Ref ref = arena.add(data, size);
+        uint32_t id = (uint32_t)refs.size();
+        refs.push_back(ref);
+        ids.emplace(std::string_view(arena.data(ref), size), id);
+        return id;
+    }
+
+    std::string_view get(uint32_t id) const {
+        return std::string_view(arena.data(refs[id]), refs[id].length);
+    }
+
+    size_t size() const { return refs.size() - 1; }
+
+    size_t memory_bytes() const {
+        // Hash nodes are estimated as key, value and next pointer
+        return arena.capacity_bytes() + refs.capacity() * sizeof(StringArena::Ref) +
+               ids.bucket_count() * sizeof(void*) +
+               ids.size() * (sizeof(std::string_view) + sizeof(uint32_t) + sizeof(void*));
+    }
+
+private:
+    StringArena arena;
+    std::vector<StringArena::Ref> refs;
+    std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+// Approximates the registrable domain (eTLD+1) of a host without the full
+// public suffix list: the last two labels, or three under the usual
+// second-level registries of country domains (co.uk, com.au, ...). Ports,
+// user info and IP addresses are handled.
+inline std::string registrable_domain(std::string host) {
+    size_t at = host.rfind('@');
+    if (at != std::string::npos) {
+        host.erase(0, at + 1);
+    }
+    if (!host.empty() && host[0] == '[') {
+        return host.substr(0, host.find(']') + 1); // IPv6 literal
+    }
+    size_t colon = host.find(':');
+    if (colon != std::string::npos) {
+        host.erase(colon);
+    }
+    for (char& c : host) {
+        c = g_ascii_tolower(c);
+    }
+    if (!host.empty() && host.back() == '.') {
+        host.pop_back();
+    }
+    if (host.find_first_not_of("0123456789.") == std::string::npos) {
+        return host; // IPv4
+    }
+
+    size_t last_dot = host.rfind('.');
+    if (last_dot == std::string::npos || last_dot == 0) return host;
+    size_t second_dot = host.rfind('.', last_dot - 1);
+    if (second_dot == std::string::npos) return host;
+
+    static const std::unordered_set<std::string> second_level = {
+        "ac", "co", "com", "edu", "gov", "net", "org", "or", "ne", "go", "gob", "mil", "nic"
+    };
+    bool country_tld = host.size() - last_dot - 1 == 2;
+    std::string second_label = host.substr(second_dot + 1, last_dot - second_dot - 1);
+    if (country_tld && second_level.count(second_label) && second_dot > 0) {
+        size_t third_dot = host.rfind('.', second_dot - 1);
+        return third_dot == std::string::npos ? host : host.substr(third_dot + 1);
+    }
+    return host.substr(second_dot + 1);
+}
+
+// Entry counts for one host, domain or scheme, or for the whole list
+struct StatsBucket {
+    uint32_t total = 0;
+    uint32_t pending = 0;
+    uint32_t done = 0;
+    uint32_t failed = 0;
+    uint32_t untitled = 0;
+
+    void count(FetchStatus status, bool untitled_entry, int delta) {
+        total += delta;
+        if (status == FETCH_DONE) done += delta;
+        else if (status == FETCH_FAILED) failed += delta;
+        else pending += delta;
+        if (untitled_entry) untitled += delta;
+    }
+};
+
+// Column storage for the list, indexed by entry id. A URL is split into its
+// interned origin (scheme://host[:port]) and the rest, so a host shared by
+// many rows is stored once; a title equal to its URL takes no space. Ids of
+// removed entries go on a free list for reuse, but an id stays held while a
+// fetch or the similarity dialog still refers to it, so late results can't
+// land on a newer entry.
+class EntryStore {
+public:
+    struct MemoryUsage {
+        size_t entries = 0;
+        size_t hosts = 0;
+        size_t column_bytes = 0;
+        size_t string_bytes = 0;
+        size_t wasted_bytes = 0;
+        size_t intern_bytes = 0;
+
+        size_t total_bytes() const { return column_bytes + string_bytes + intern_bytes; }
+        double bytes_per_entry() const { return entries ? (double)total_bytes() / entries : 0.0; }
+    };
+
+    enum StatsGroup { GROUP_DOMAIN = 0, GROUP_HOST = 1, GROUP_STATUS = 2, GROUP_SCHEME = 3 };
+
+    // Keys of the GROUP_STATUS buckets
+    enum StatusBucket { BUCKET_PENDING = 0, BUCKET_DONE = 1, BUCKET_FAILED = 2, BUCKET_UNTITLED = 3 };
+
+    struct StatsRow {
+        uint32_t key;
+        std::string name;
+        StatsBucket counts;
+    };
+
+    // Ids of removed entries are handed out again, so the columns only
+    // grow with the largest number of entries held at once
+    uint32_t add(const std::string& title, const std::string& url) {
+        uint32_t id;
+        if (!free_ids.empty()) {
+            id = free_ids.back();
+            free_ids.pop_back();
+        } else {
+            id = (uint32_t)flags_column.size();
+            origin_column.push_back(0);
+            path_column.push_back(StringArena::Ref());
+            flags_column.push_back(FLAG_REMOVED);
+            title_column.push_back(StringArena::Ref());
+            final_url_column.push_back(StringArena::Ref());
+            icon_column.push_back(0);
+            fetched_at_column.push_back(0);
+        }
+        size_t path_start = 0;
+        origin_column[id] = intern_origin(url, path_start);
+        path_column[id] = strings.add(url.data() + path_start, url.size() - path_start);
+        // Counted once the title is in place
+        flags_column[id] = FLAG_REMOVED | FETCH_PENDING;
+        icon_column[id] = 0;
+        fetched_at_column[id] = 0;
+        set_title(id, title);
+        flags_column[id] &= ~FLAG_REMOVED;
+        count(id, 1);
+        live++;
+        return id;
+    }
+
+    void remove(uint32_t id) {
+        if (flags_column[id] & FLAG_REMOVED) return;
+        count(id, -1);
+        strings.release(path_column[id]);
+        strings.release(title_column[id]);
+        strings.release(final_url_column[id]);
+        path_column[id] = title_column[id] = final_url_column[id] = StringArena::Ref();
+        flags_column[id] = FLAG_REMOVED;
+        live--;
+        if (!holds.count(id)) {
+            free_ids.push_back(id);
+        }
+        compact_if_wasteful();
+    }
+
+    // Keeps the id from being handed out again, even once removed, while
+    // something outside the store still refers to it (a fetch in flight)
+    void hold(uint32_t id) { holds[id]++; }
+
+    void release(uint32_t id) {
+        auto held = holds.find(id);
+        if (held == holds.end() || --held->second > 0) return;
+        holds.erase(held);
+        if (flags_column[id] & FLAG_REMOVED) {
+            free_ids.push_back(id);
+        }
+    }
+
+    std::string url(uint32_t id) const {
+        std::string_view origin = origins.get(origin_column[id]);
+        std::string result;
+        result.reserve(origin.size() + path_column[id].length);
+        result.append(origin.data(), origin.size());
+        result.append(strings.data(path_column[id]), path_column[id].length);
+        return result;
+    }
+
+    std::string title(uint32_t id) const {
+        return (flags_column[id] & FLAG_TITLE_IS_URL) ? url(id) : strings.get(title_column[id]);
+    }
+
+    void set_title(uint32_t id, const std::string& title) {
+        count(id, -1);
+        strings.release(title_column[id]);
+        if (title == url(id)) {
+            title_column[id] = StringArena::Ref();
+            flags_column[id] |= FLAG_TITLE_IS_URL;
+        } else {
+            title_column[id] = strings.add(title);
+            flags_column[id] &= ~FLAG_TITLE_IS_URL;
+        }
+        count(id, 1);
+        compact_if_wasteful();
+    }
+
+    std::string final_url(uint32_t id) const { return strings.get(final_url_column[id]); }
+
+    void set_final_url(uint32_t id, const std::string& url) {
+        strings.release(final_url_column[id]);
+        final_url_column[id] = strings.add(url);
+        compact_if_wasteful();
+    }
+
+    // Icon keys are origins, so they share the origin table
+    std::string icon_key(uint32_t id) const { return std::string(origins.get(icon_column[id])); }
+    void set_icon_key(uint32_t id, const std::string& key) { icon_column[id] = origins.intern(key.data(), key.size()); }
+
+    FetchStatus status(uint32_t id) const { return (FetchStatus)(flags_column[id] & STATUS_MASK); }
+    void set_status(uint32_t id, FetchStatus status) {
+        count(id, -1);
+        flags_column[id] = (flags_column[id] & ~STATUS_MASK) | (uint8_t)status;
+        count(id, 1);
+    }
+
+    gint64 fetched_at(uint32_t id) const { return fetched_at_column[id]; }
+    void set_fetched_at(uint32_t id, gint64 time) { fetched_at_column[id] = (uint32_t)time; }
+
+    // Interned host (with port) of the entry's URL; 0 when it has none
+    uint32_t host_id(uint32_t id) const { return origin_hosts[origin_column[id]]; }
+    std::string_view host(uint32_t host_id) const { return hosts.get(host_id); }
+
+    // Bumped by every change to the counts, so views can skip refreshes
+    uint64_t change_count() const { return changes; }
+
+    const StatsBucket& totals() const { return total_stats; }
+    size_t host_count() const { return hosts.size(); }
+    size_t domain_count() const { return domains.size(); }
+
+    // The non-empty buckets of group, largest first, at most limit of them
+    std::vector<StatsRow> top_buckets(StatsGroup group, size_t limit) const {
+        std::vector<StatsRow> rows;
+        if (group == GROUP_STATUS) {
+            static const char* const names[] = {"Pending", "Icon found", "No icon / unreachable", "Untitled"};
+            uint32_t counts[] = {total_stats.pending, total_stats.done, total_stats.failed, total_stats.untitled};
+            for (uint32_t key = 0; key < 4; ++key) {
+                if (counts[key] == 0) continue;
+                StatsRow row{key, names[key], StatsBucket()};
+                row.counts.total = counts[key];
+                rows.push_back(row);
+            }
+        } else {
+            const std::vector<StatsBucket>& buckets = bucket_column(group);
+            std::vector<uint32_t> keys;
+            for (uint32_t key = 0; key < buckets.size(); ++key) {
+                if (buckets[key].total > 0) keys.push_back(key);
+            }
+            auto larger = [&buckets](uint32_t a, uint32_t b) { return buckets[a].total > buckets[b].total; };
+            if (keys.size() > limit) {
+                std::partial_sort(keys.begin(), keys.begin() + limit, keys.end(), larger);
+                keys.resize(limit);
+            } else {
+                std::sort(keys.begin(), keys.end(), larger);
+            }
+
+            const InternTable& names = group == GROUP_DOMAIN ? domains : group == GROUP_HOST ? hosts : schemes;
+            for (uint32_t key : keys) {
+                std::string name(names.get(key));
+                rows.push_back(StatsRow{key, name.empty() ? "(none)" : name, buckets[key]});
+            }
+        }
+        std::sort(rows.begin(), rows.end(), [](const StatsRow& a, const StatsRow& b) { return a.counts.total > b.counts.total; });
+        return rows;
+    }
+
+    bool in_bucket(uint32_t id, StatsGroup group, uint32_t key) const {
+        uint32_t origin = origin_column[id];
+        switch (group) {
+        case GROUP_DOMAIN: return origin_domains[origin] == key;
+        case GROUP_HOST: return origin_hosts[origin] == key;
+        case GROUP_SCHEME: return origin_schemes[origin] == key;
+        case GROUP_STATUS:
+            return key == BUCKET_UNTITLED ? (flags_column[id] & FLAG_TITLE_IS_URL) != 0 : status(id) == (FetchStatus)key;
+        }
+        return false;
+    }
+
+    // Memory held by the store, live entries only in the count
+    MemoryUsage memory_usage() const {
+        MemoryUsage usage;
+        usage.entries = live;
+        usage.hosts = hosts.size();
+        usage.column_bytes = origin_column.capacity() * sizeof(uint32_t) +
+                             path_column.capacity() * sizeof(StringArena::Ref) +
+                             title_column.capacity() * sizeof(StringArena::Ref) +
+                             final_url_column.capacity() * sizeof(StringArena::Ref) +
+                             icon_column.capacity() * sizeof(uint32_t) +
+                             flags_column.capacity() * sizeof(uint8_t) +
+                             fetched_at_column.capacity() * sizeof(uint32_t) +
+                             origin_hosts.capacity() * sizeof(uint32_t) * 3 +
+                             (host_stats.capacity() + domain_stats.capacity() + scheme_stats.capacity()) * sizeof(StatsBucket);
+        usage.string_bytes = strings.capacity_bytes();
+        usage.wasted_bytes = strings.wasted_bytes();
+        usage.intern_bytes = origins.memory_bytes() + hosts.memory_bytes() + domains.memory_bytes() + schemes.memory_bytes();
+        return usage;
+    }
+
+private:
+    enum : uint8_t {
+        STATUS_MASK = 0x03,
+        FLAG_TITLE_IS_URL = 0x04,
+        FLAG_REMOVED = 0x08
+    };
+
+    // Interns the scheme://host[:port] part of url and returns its id;
+    // path_start is set to where the rest of the URL begins
+    uint32_t intern_origin(const std::string& url, size_t& path_start) {
+        path_start = 0;
+        size_t scheme_end = url.find("://");
+        if (scheme_end == std::string::npos || scheme_end == 0) return 0;
+        size_t host_start = scheme_end + 3;
+        size_t host_end = url.find_first_of("/?#", host_start);
+        if (host_end == std::string::npos) {
+            host_end = url.size();
+        }
+        if (host_end == host_start) return 0;
+
+        uint32_t origin = origins.intern(url.data(), host_end);
+        if (origin >= origin_hosts.size()) {
+            std::string host = url.substr(host_start, host_end - host_start);
+            std::string domain = registrable_domain(host);
+            std::string scheme = url.substr(0, scheme_end);
+            for (char& c : scheme) {
+                c = g_ascii_tolower(c);
+            }
+            origin_hosts.resize(origin + 1, 0);
+            origin_domains.resize(origin + 1, 0);
+            origin_schemes.resize(origin + 1, 0);
+            origin_hosts[origin] = hosts.intern(host.data(), host.size());
+            origin_domains[origin] = domains.intern(domain.data(), domain.size());
+            origin_schemes[origin] = schemes.intern(scheme.data(), scheme.size());
+            host_stats.resize(hosts.size() + 1);
+            domain_stats.resize(domains.size() + 1);
+            scheme_stats.resize(schemes.size() + 1);
+        }
+        path_start = host_end;
+        return origin;
+    }
+
+    const std::vector<StatsBucket>& bucket_column(StatsGroup group) const {
+        return group == GROUP_DOMAIN ? domain_stats : group == GROUP_HOST ? host_stats : scheme_stats;
+    }
+
+    // Adds (delta 1) or takes back (delta -1) the entry's contribution to
+    // the counts. Entries being added or removed are not counted.
+    void count(uint32_t id, int delta) {
+        uint8_t flags = flags_column[id];
+        if (flags & FLAG_REMOVED) return;
+        FetchStatus entry_status = (FetchStatus)(flags & STATUS_MASK);
+        bool untitled = (flags & FLAG_TITLE_IS_URL) != 0;
+        uint32_t origin = origin_column[id];
+        total_stats.count(entry_status, untitled, delta);
+        host_stats[origin_hosts[origin]].count(entry_status, untitled, delta);
+        domain_stats[origin_domains[origin]].count(entry_status, untitled, delta);
+        scheme_stats[origin_schemes[origin]].count(entry_status, untitled, delta);
+        changes++;
+    }
+
+    // Copies the live strings into a fresh arena once more than half of
+    // the old one is garbage from removed rows and replaced titles
+    void compact_if_wasteful() {
+        if (strings.wasted_bytes() < 4 * 1024 * 1024 || strings.wasted_bytes() < strings.used_bytes() / 2) return;
+
+        StringArena compacted;
+        for (size_t id = 0; id < flags_column.size(); ++id) {
+            for (StringArena::Ref* ref : {&path_column[id], &title_column[id], &final_url_column[id]}) {
+                *ref = compacted.add(strings.data(*ref), ref->length);
+            }
+        }
+        strings = std::move(compacted);
+    }
+
+    StringArena strings;
+    InternTable origins;
+    InternTable hosts;
+    InternTable domains;
+    InternTable schemes;
+    std::vector<uint32_t> origin_hosts{0};   // host id of each origin id
+    std::vector<uint32_t> origin_domains{0}; // registrable domain id of each origin id
+    std::vector<uint32_t> origin_schemes{0}; // scheme id of each origin id
+
+    // Indexed by host, domain and scheme id; id 0 collects URLs without one
+    std::vector<StatsBucket> host_stats{1};
+    std::vector<StatsBucket> domain_stats{1};
+    std::vector<StatsBucket> scheme_stats{1};
+    StatsBucket total_stats;
+    uint64_t changes = 0;
+
+    std::vector<uint32_t> origin_column;
+    std::vector<StringArena::Ref> path_column;
+    std::vector<StringArena::Ref> title_column;
+    std::vector<StringArena::Ref> final_url_column;
+    std::vector<uint32_t> icon_column;
+    std::vector<uint8_t> flags_column;        // FetchStatus in the low bits, FLAG_* above
+    std::vector<uint32_t> fetched_at_column;  // Seconds since the epoch
+    size_t live = 0;
+    std::vector<uint32_t> free_ids;              // Removed and not held
+    std::unordered_map<uint32_t, int> holds;     // Id -> outside references
+};
+
+// Groups entries that are probably the same page under different URLs:
+// mirrors, AMP and mobile variants, reposts under another path. Each entry
+// becomes a set of shingles (title words and word pairs, URL path words)
+// summarized by a MinHash signature. Locality-sensitive hashing over bands
+// of the signatures proposes candidates, kept when their estimated Jaccard
+// similarity reaches the threshold, so the work grows with the number of
+// entries rather than the number of pairs. Signatures and bands are spread
+// over all cores.
+class NearDuplicateFinder {
+public:
+    struct Entry {
+        uint32_t id;
+        std::string title; // empty when the entry has none
+        std::string url;
+    };
+
+    explicit NearDuplicateFinder(double threshold = 0.6) : threshold(threshold) {}
+
+    // Clusters of two or more ids, largest first
+    std::vector<std::vector<uint32_t>> find(const std::vector<Entry>& entries) const {
+        size_t count = entries.size();
+        std::vector<uint32_t> signatures(count * hash_count);
+        std::vector<uint8_t> usable(count, 0);
+        run_parallel(count, [&](size_t begin, size_t end) {
+            std::vector<uint64_t> entry_shingles;
+            for (size_t i = begin; i < end; ++i) {
+                shingles(entries[i], entry_shingles);
+                // Too little text to tell pages apart ("Home", "/")
+                if (entry_shingles.size() < min_shingles) continue;
+                signature(entry_shingles, &signatures[i * hash_count]);
+                usable[i] = 1;
+            }
+        });
+
+        // Each band is bucketed on its own; entries sharing a bucket with
+        // the bucket's first entry are compared against it
+        std::vector<std::vector<std::pair<uint32_t, uint32_t>>> band_pairs(band_count);
+        run_parallel(band_count, [&](size_t begin, size_t end) {
+            std::vector<std::pair<uint64_t, uint32_t>> keys;
+            for (size_t band = begin; band < end; ++band) {
+                keys.clear();
+                for (size_t i = 0; i < count; ++i) {
+                    if (!usable[i]) continue;
+                    const uint32_t* rows = &signatures[i * hash_count + band * rows_per_band];
+                    uint64_t key = band;
+                    for (int row = 0; row < rows_per_band; ++row) {
+                        key = mix(key ^ rows[row]);
+                    }
+                    keys.emplace_back(key, (uint32_t)i);
+                }
+                std::sort(keys.begin(), keys.end());
+
+                for (size_t first = 0; first < keys.size();) {
+                    size_t next = first + 1;
+                    for (; next < keys.size() && keys[next].first == keys[first].first; ++next) {
+                        uint32_t a = keys[first].second;
+                        uint32_t b = keys[next].second;
+                        if (similarity(&signatures[a * hash_count], &signatures[b * hash_count]) >= threshold) {
+                            band_pairs[band].emplace_back(a, b);
+                        }
+                    }
+                    first = next;
+                }
+            }
+        });
+
+        std::vector<uint32_t> parent(count);
+        for (size_t i = 0; i < count; ++i) {
+            parent[i] = (uint32_t)i;
+        }
+        auto root = [&parent](uint32_t i) {
+            while (parent[i] != i) {
+                parent[i] = parent[parent[i]];
+                i = parent[i];
+            }
+            return i;
+        };
+        for (const auto& pairs : band_pairs) {
+            for (const auto& pair : pairs) {
+                uint32_t a = root(pair.first);
+                uint32_t b = root(pair.second);
+                if (a != b) {
+                    parent[std::max(a, b)] = std::min(a, b);
+                }
+            }
+        }
+
+        // Members stay in list order
+        std::unordered_map<uint32_t, std::vector<uint32_t>> groups;
+        for (size_t i = 0; i < count; ++i) {
+            groups[root((uint32_t)i)].push_back(entries[i].id);
+        }
+        std::vector<std::vector<uint32_t>> clusters;
+        for (auto& group : groups) {
+            if (group.second.size() > 1) {
+                clusters.push_back(std::move(group.second));
+            }
+        }
+        std::sort(clusters.begin(), clusters.end(), [](const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+            return a.size() != b.size() ? a.size() > b.size() : a.front() < b.front();
+        });
+        return clusters;
+    }
+
+private:
+    static const int band_count = 10;
+    static const int rows_per_band = 4; // ~0.56 similarity to share a band by chance half the time
+    static const int hash_count = band_count * rows_per_band;
+    static const size_t min_shingles = 3;
+
+    template <typename Work>
+    static void run_parallel(size_t count, Work work) {
+        size_t threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+        if (threads <= 1) {
+            work(0, count);
+            return;
+        }
+        std::vector<std::thread> workers;
+        size_t chunk = (count + threads - 1) / threads;
+        for (size_t begin = 0; begin < count; begin += chunk) {
+            workers.emplace_back(work, begin, std::min(begin + chunk, count));
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // splitmix64 finalizer
+    static uint64_t mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    // FNV-1a over lowercased bytes
+    static uint64_t hash_word(const char* data, size_t size) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ (unsigned char)g_ascii_tolower(data[i])) * 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    // Calls emit for each run of letters and digits; bytes of multi-byte
+    // UTF-8 characters count as letters
+    template <typename Emit>
+    static void split_words(const std::string& text, size_t begin, size_t end, Emit emit) {
+        size_t start = begin;
+        for (size_t i = begin; i <= end; ++i) {
+            unsigned char c = i < end ? (unsigned char)text[i] : ' ';
+            if (c >= 0x80 || g_ascii_isalnum(c)) continue;
+            if (i - start > 1) {
+                emit(text.data() + start, i - start);
+            }
+            start = i + 1;
+        }
+    }
+
+    static void shingles(const Entry& entry, std::vector<uint64_t>& out) {
+        out.clear();
+        uint64_t previous = 0;
+        split_words(entry.title, 0, entry.title.size(), [&](const char* word, size_t size) {
+            uint64_t hash = hash_word(word, size);
+            out.push_back(hash);
+            if (previous) {
+                out.push_back(mix(previous) ^ hash);
+            }
+            previous = hash;
+        });
+
+        // Path words only: the host differs between mirrors, and query
+        // strings are mostly tracking parameters
+        size_t host = entry.url.find("://");
+        size_t path = entry.url.find('/', host == std::string::npos ? 0 : host + 3);
+        if (path != std::string::npos) {
+            size_t path_end = std::min(entry.url.find('?', path), entry.url.find('#', path));
+            static const std::unordered_set<std::string> noise = {
+                "amp", "www", "index", "html", "htm", "php", "aspx", "jsp", "mobile", "en", "article", "articles",
+                "post", "posts", "news", "story", "blog", "www2"
+            };
+            split_words(entry.url, path, std::min(path_end, entry.url.size()), [&](const char* word, size_t size) {
+                std::string lower(word, size);
+                for (char& c : lower) {
+                    c = g_ascii_tolower(c);
+                }
+                if (noise.count(lower) == 0) {
+                    out.push_back(hash_word(word, size) ^ 0x5bd1e995ULL); // apart from title words
+                }
+            });
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+
+    static void signature(const std::vector<uint64_t>& entry_shingles, uint32_t* out) {
+        for (int i = 0; i < hash_count; ++i) {
+            uint64_t seed = mix(i + 1);
+            uint64_t minimum = UINT64_MAX;
+            for (uint64_t shingle : entry_shingles) {
+                minimum = std::min(minimum, mix(shingle ^ seed));
+            }
+            out[i] = (uint32_t)(minimum >> 32);
+        }
+    }
+
+    static double similarity(const uint32_t* a, const uint32_t* b) {
+        int equal = 0;
+        for (int i = 0; i < hash_count; ++i) {
+            equal += a[i] == b[i];
+        }
+        return (double)equal / hash_count;
+    }
+
+    double threshold;
+};
+
+// What every window of the process shares: one connection pool (a curl
+// share handle, so DNS answers, TLS sessions and keep-alive connections
+// carry over between lists), one limit on concurrent fetches, the decoded
+// icons by origin, the title cache and the page archive. A host fetched
+// for one list is then known to all of them. Main thread only, apart from
+// configure() and the caches' own locking.
+class FetchEngine {
+public:
+    // Never destroyed: detached fetch threads may still use the share
+    // handle while the process exits
+    static FetchEngine& instance() {
+        static FetchEngine* engine = new FetchEngine();
+        return *engine;
+    }
+
+    // Attaches a transfer to the shared connection pool
+    void configure(CURL* curl) {
+        if (share) {
+            curl_easy_setopt(curl, CURLOPT_SHARE, share);
+        }
+    }
+
+    // Opens the on-disk title cache and page archive, once. Windows that
+    // must not touch the user's files (the benchmarks) never call this.
+    void open_stores() {
+        if (stores_opened) return;
+        stores_opened = true;
+
+        std::string cache_dir = Glib::build_filename(Glib::get_user_cache_dir(), "url-editor");
+        g_mkdir_with_parents(cache_dir.c_str(), 0700);
+        metadata_cache = std::make_shared<MetadataCache>(Glib::build_filename(cache_dir, "metadata.db"));
+        if (!metadata_cache->is_open()) {
+            metadata_cache.reset();
+        }
+
+        std::string data_dir = Glib::build_filename(Glib::get_user_data_dir(), "url-editor");
+        g_mkdir_with_parents(data_dir.c_str(), 0700);
+        page_archive = std::make_shared<PageArchive>(data_dir);
+        if (!page_archive->is_open()) {
+            page_archive.reset();
+        }
+    }
+
+    bool has_capacity() const { return running < max_running; }
+
+    void begin_fetch() { running++; }
+
+    // Windows waiting for a free slot are pumped once per burst of
+    // finished fetches, from idle rather than inside the finishing window
+    void end_fetch() {
+        running--;
+        if (capacity_notify_pending) return;
+        capacity_notify_pending = true;
+        Glib::signal_idle().connect_once([this]() {
+            capacity_notify_pending = false;
+            signal_capacity_available.emit();
+        });
+    }
+
+    sigc::signal<void> signal_capacity_available;
+    std::unordered_map<std::string, Glib::RefPtr<Gdk::Pixbuf>> icons; // keyed by scheme://host
+    std::unordered_map<std::string, std::string> short_links;          // this run's expansions, failures map to themselves
+    std::shared_ptr<MetadataCache> metadata_cache;
+    std::shared_ptr<PageArchive> page_archive;
+
+private:
+    FetchEngine() {
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+        share = curl_share_init();
+        if (!share) {
+            g_warning("Failed to create the shared connection pool");
+            return;
+        }
+        curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lock_shared);
+        curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlock_shared);
+        curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+
+    static void lock_shared(CURL*, curl_lock_data data, curl_lock_access, void* self) {
+        ((FetchEngine*)self)->share_locks[data].lock();
+    }
+
+    static void unlock_shared(CURL*, curl_lock_data data, void* self) {
+        ((FetchEngine*)self)->share_locks[data].unlock();
+    }
+
+    CURLSH* share = nullptr;
+    std::mutex share_locks[CURL_LOCK_DATA_LAST];
+    bool stores_opened = false;
+    int running = 0;
+    const int max_running = 8; // Across all windows
+    bool capacity_notify_pending = false;
+};
+
+// Outcome of one fetch step, handed from a fetch thread to the main thread
+struct FetchResult {
+    enum Kind : uint8_t {
+        RESOLVED, // final_url is where the row's short link leads, empty if unknown
+        ICON,     // pixbuf is the row's favicon, or null when none was found
+        TITLE,    // title (empty when the page had none); finishes the row
+        DONE      // the row is finished without a title
+    };
+
+    Kind kind = DONE;
+    int row_id = -1;
+    int generation = 0;
+    Glib::RefPtr<Gdk::Pixbuf> pixbuf;
+    std::string icon_key;
+    std::string title;
+    std::string final_url;
+};
+
+// Where fetch threads leave their results. The threads share ownership,
+// because a window may be deleted as soon as a thread's last result has
+// been applied, while that thread is still returning from post().
+// on_ready is only touched on the main thread.
+struct FetchResultChannel : std::enable_shared_from_this<FetchResultChannel> {
+    BoundedMpscQueue<FetchResult> results{4096};
+    std::atomic<bool> drain_scheduled{false};
+    std::function<void()> on_ready; // Cleared when the window goes away
+
+    // Called on fetch threads; a single drain is scheduled per burst
+    void post(FetchResult&& result) {
+        results.push(std::move(result));
+        if (!drain_scheduled.exchange(true)) {
+            std::shared_ptr<FetchResultChannel> self = shared_from_this();
+            Glib::signal_idle().connect_once([self]() {
+                if (self->on_ready) {
+                    self->on_ready();
+                }
+            });
+        }
+    }
+};
+
+// Custom row widget for list items. The entry's data lives in the
+// EntryStore; the row only shows it.
+class UrlRow : public Gtk::Box {
+public:
+    UrlRow(EntryStore& store, int id, const Glib::ustring& title, const Glib::ustring& url)
+        : Gtk::Box(Gtk::ORIENTATION_HORIZONTAL, 10), store(store), row_id(id) {
+        set_margin_start(5);
+        set_margin_end(5);
+        set_margin_top(5);
+        set_margin_bottom(5);
+
+        // Create number label
+        number_label = Gtk::manage(new Gtk::Label("0"));
+        number_label->set_halign(Gtk::ALIGN_START);
+        number_label->set_valign(Gtk::ALIGN_START);
+        number_label->set_width_chars(4);
+        number_label->set_margin_end(10);
+        pack_start(*number_label, false, false);
+
+        // Create icon
+        icon_image = Gtk::manage(new Gtk::Image());
+        icon_image->set_size_request(32, 32);
+        pack_start(*icon_image, false, false);
+
+        // Create vertical box for title and URL (each on their own line)
+        Gtk::Box* text_box = Gtk::manage(new Gtk::Box(Gtk::ORIENTATION_VERTICAL, 2));
+
+        // Create title label (single line, no wrapping, no ellipsize for horizontal scroll)
+        title_label = Gtk::manage(new Gtk::Label(title));
+        title_label->set_halign(Gtk::ALIGN_START);
+        title_label->set_valign(Gtk::ALIGN_START);
+        title_label->set_single_line_mode(true);
+        title_label->set_ellipsize(Pango::ELLIPSIZE_NONE);
+        text_box->pack_start(*title_label, false, false);
+
+        // Create URL label (single line, no wrapping, blue and underlined, no ellipsize for horizontal scroll)
+        url_label = Gtk::manage(new Gtk::Label());
+        url_label->set_halign(Gtk::ALIGN_START);
+        url_label->set_valign(Gtk::ALIGN_START);
+        url_label->set_single_line_mode(true);
+        url_label->set_ellipsize(Pango::ELLIPSIZE_NONE);
+        url_label->set_selectable(false);
+
+        // Make it look like a link (blue and underlined via markup)
+        Glib::ustring url_markup = "<span underline=\"single\" color=\"#0000FF\">" +
+                                   Glib::Markup::escape_text(url) + "</span>";
+        url_label->set_markup(url_markup);
+
+        text_box->pack_start(*url_label, false, false);
+
+        pack_start(*text_box, true, true);
+
+        show_all();
+    }
+
+    void set_icon(Glib::RefPtr<Gdk::Pixbuf> pixbuf) {
+        if (pixbuf) {
+            if (pixbuf->get_width() != 32 || pixbuf->get_height() != 32) {
+                pixbuf = pixbuf->scale_simple(32, 32, Gdk::INTERP_BILINEAR);
+            }
+            icon_image->set(pixbuf);
+        }
+    }
+
+    void set_icon_key(const std::string& key) { store.set_icon_key(row_id, key); }
+    void set_status(FetchStatus new_status) { store.set_status(row_id, new_status); }
+    void set_fetched_at(gint64 time) { store.set_fetched_at(row_id, time); }
+    void set_final_url(const std::string& url) { store.set_final_url(row_id, url); }
+
+    void set_number(int number) {
+        if (number == row_number) return;
+        row_number = number;
+        number_label->set_text(Glib::ustring::compose("%1.", number));
+    }
+
+    void set_title(const Glib::ustring& new_title) {
+        store.set_title(row_id, new_title.raw());
+        title_label->set_text(new_title);
+    }
+
+    int get_id() const { return row_id; }
+    Glib::ustring get_url() const { return store.url(row_id); }
+    Glib::ustring get_title() const { return store.title(row_id); }
+    std::string get_final_url() const { return store.final_url(row_id); }
+    std::string get_icon_key() const { return store.icon_key(row_id); }
+    FetchStatus get_status() const { return store.status(row_id); }
+    gint64 get_fetched_at() const { return store.fetched_at(row_id); }
+
+private:
+    EntryStore& store;
+    int row_id;
+    int row_number = 0;
+    Gtk::Label* number_label;
+    Gtk::Image* icon_image;
+    Gtk::Label* title_label;
+    Gtk::Label* url_label;
+};
+
+class UrlEditorWindow : public Gtk::Window {
+public:
+    // use_session is false for throwaway windows (the benchmark suite),
+    // which must not read or overwrite the user's saved list
+    explicit UrlEditorWindow(bool use_session = true) {
+        set_title("URL Editor");
+        set_default_size(900, 1000); // WxH
+        set_border_width(10);
+        settings.load();
+
+        // Create main box
+        main_box = Gtk::manage(new Gtk::Box(Gtk::ORIENTATION_VERTICAL, 10));
+        add(*main_box);
+
+        // Create header box with URL count
+        header_box = Gtk::manage(new Gtk::Box(Gtk::ORIENTATION_HORIZONTAL, 10));
+
+        url_count_label = Gtk::manage(new Gtk::Label("URLs: 0"));
+        url_count_label->set_halign(Gtk::ALIGN_START);
+        header_box->pack_start(*url_count_label, false, false);
+        header_box->pack_end(*Gtk::manage(new Gtk::Label()), true, true);
+
+        stats_check = Gtk::manage(new Gtk::CheckButton("Statistics"));
+        stats_check->set_tooltip_text("Show counts by domain, host, fetch status and scheme; select one to filter the list");
+        stats_check->signal_toggled().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_stats_toggled));
+        header_box->pack_end(*stats_check, false, false);
+
+        Gtk::Button* new_window_button = Gtk::manage(new Gtk::Button("New window"));
+        new_window_button->set_tooltip_text("Open another list (Ctrl+N); all windows share fetched icons and titles");
+        new_window_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_new_window_clicked));
+        header_box->pack_end(*new_window_button, false, false);
+
+        // Create mode selection
+        Gtk::Box* mode_box = Gtk::manage(new Gtk::Box(Gtk::ORIENTATION_HORIZONTAL, 10));
+        Gtk::Label* mode_label = Gtk::manage(new Gtk::Label("Input format:"));
+        mode_label->set_halign(Gtk::ALIGN_START);
+        mode_box->pack_start(*mode_label, false, false);
+
+        mode1_radio = Gtk::manage(new Gtk::RadioButton("Title-URL pairs (with blank lines)"));
+        Gtk::RadioButtonGroup group = mode1_radio->get_group();
+        mode2_radio = Gtk::manage(new Gtk::RadioButton(group, "URLs only (one per line, optional # title)"));
+        mode2_radio->set_active(true); // Default to mode 2
+
+        mode_box->pack_start(*mode1_radio, false, false);
+        mode_box->pack_start(*mode2_radio, false, false);
+
+        live_sync_check = Gtk::manage(new Gtk::CheckButton("Live sync"));
+        live_sync_check->set_tooltip_text("Keep the text and the list in sync while editing either one");
+        mode_box->pack_start(*live_sync_check, false, false);
+        main_box->pack_start(*mode_box, false, false);
+
+        live_sync_check->signal_toggled().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_live_sync_toggled));
+        mode2_radio->signal_toggled().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_mode_toggled));
+
+        main_box->pack_start(*header_box, false, false);
+
+        // Create scrolled window for text view
+        url_text_scrolled = Gtk::manage(new Gtk::ScrolledWindow());
+        url_text_scrolled->set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+        url_text_scrolled->set_min_content_height(150);
+        url_text_scrolled->set_vexpand(false);
+
+        url_text_view = Gtk::manage(new Gtk::TextView());
+        url_text_view->set_editable(true);
+        url_text_view->set_cursor_visible(true);
+        url_text_view->set_wrap_mode(Gtk::WRAP_NONE);
+        url_text_view->set_monospace(true);
+        url_text_scrolled->add(*url_text_view);
+        main_box->pack_start(*url_text_scrolled, false, false);
+
+        // Track edits before the buffer applies them, while the ranges are still valid
+        Glib::RefPtr<Gtk::TextBuffer> text_buffer = url_text_view->get_buffer();
+        text_buffer->signal_insert().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_buffer_insert), false);
+        text_buffer->signal_erase().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_buffer_erase), false);
+
+        // Create scrolled window for list (with horizontal scrolling)
+        scrolled_window = Gtk::manage(new Gtk::ScrolledWindow());
+        scrolled_window->set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+        scrolled_window->set_vexpand(true);
+        scrolled_window->set_hexpand(true);
+        scrolled_window->set_min_content_width(600); // Minimum width before horizontal scroll appears
+
+        // Create list box
+        list_box = Gtk::manage(new Gtk::ListBox());
+        list_box->set_selection_mode(Gtk::SELECTION_MULTIPLE);
+        list_box->set_hexpand(false); // Allow list to expand beyond window width for horizontal scroll
+        scrolled_window->add(*list_box);
+
+        // The list shares its space with the statistics panel
+        Gtk::Paned* list_paned = Gtk::manage(new Gtk::Paned(Gtk::ORIENTATION_HORIZONTAL));
+        list_paned->pack1(*scrolled_window, true, false);
+        list_paned->pack2(*create_stats_panel(), false, true);
+        main_box->pack_start(*list_paned, true, true);
+
+        // Track the viewport so rows on screen are fetched first
+        Glib::RefPtr<Gtk::Adjustment> vadjustment = scrolled_window->get_vadjustment();
+        vadjustment->signal_value_changed().connect(sigc::mem_fun(*this, &UrlEditorWindow::queue_visible_rows_update));
+        vadjustment->signal_changed().connect(sigc::mem_fun(*this, &UrlEditorWindow::queue_visible_rows_update));
+
+        // Connect signals
+        list_box->signal_row_activated().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_row_activated));
+        list_box->signal_button_press_event().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_button_press));
+        list_box->signal_selected_rows_changed().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_selected_rows_changed));
+
+        // Add keyboard shortcuts - handle key press events
+        signal_key_press_event().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_key_press), false);
+
+        // Results queued by fetch threads are applied from the main loop
+        fetch_results->on_ready = [this]() { start_results_drain(); };
+
+        // Create button box
+        button_box = Gtk::manage(new Gtk::Box(Gtk::ORIENTATION_HORIZONTAL, 10));
+
+        load_button = Gtk::manage(new Gtk::Button("Load from text"));
+        import_button = Gtk::manage(new Gtk::Button("Import..."));
+        watch_button = Gtk::manage(new Gtk::Button("Watch file..."));
+        watch_button->set_tooltip_text("Follow a URL list file and add lines as they are appended to it");
+        save_button = Gtk::manage(new Gtk::Button("Export to text"));
+        export_file_button = Gtk::manage(new Gtk::Button("Export to file..."));
+        refresh_button = Gtk::manage(new Gtk::Button("Refresh Icons"));
+        find_similar_button = Gtk::manage(new Gtk::Button("Find similar"));
+        find_similar_button->set_tooltip_text("Group entries that look like the same page under different URLs");
+
+        // Movement and delete buttons
+        move_up_button = Gtk::manage(new Gtk::Button("↑"));
+        move_down_button = Gtk::manage(new Gtk::Button("↓"));
+        delete_button = Gtk::manage(new Gtk::Button("Delete"));
+        copy_url_button = Gtk::manage(new Gtk::Button("Copy URL"));
+        open_browser_button = Gtk::manage(new Gtk::Button("Open in browser"));
+        archive_button = Gtk::manage(new Gtk::Button("Archive selected"));
+        archive_button->set_tooltip_text("Save the selected pages for offline reading");
+
+        load_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_load_clicked));
+        import_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_import_clicked));
+        watch_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_watch_clicked));
+        save_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_save_clicked));
+        export_file_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_export_file_clicked));
+        refresh_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_refresh_clicked));
+        find_similar_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_find_similar_clicked));
+        move_up_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_move_up_clicked));
+        move_down_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_move_down_clicked));
+        delete_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_delete_clicked));
+        copy_url_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_copy_url_clicked));
+        open_browser_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_open_browser_clicked));
+        archive_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_archive_clicked));
+
+        button_box->pack_start(*load_button, false, false);
+        button_box->pack_start(*import_button, false, false);
+        button_box->pack_start(*watch_button, false, false);
+        button_box->pack_start(*save_button, false, false);
+        button_box->pack_start(*export_file_button, false, false);
+        button_box->pack_start(*refresh_button, false, false);
+        button_box->pack_start(*find_similar_button, false, false);
+        button_box->pack_start(*Gtk::manage(new Gtk::Separator(Gtk::ORIENTATION_VERTICAL)), false, false);
+        button_box->pack_start(*move_up_button, false, false);
+        button_box->pack_start(*move_down_button, false, false);
+        button_box->pack_start(*delete_button, false, false);
+        button_box->pack_start(*copy_url_button, false, false);
+        button_box->pack_start(*open_browser_button, false, false);
+        button_box->pack_start(*archive_button, false, false);
+        button_box->pack_end(*Gtk::manage(new Gtk::Label()), true, true);
+
+        // Initially disable movement buttons (no selection)
+        move_up_button->set_sensitive(false);
+        move_down_button->set_sensitive(false);
+        delete_button->set_sensitive(false);
+        copy_url_button->set_sensitive(false);
+        archive_button->set_sensitive(false);
+
+        main_box->pack_start(*button_box, false, false);
+
+        // Create status bar
+        status_box = Gtk::manage(new Gtk::Box(Gtk::ORIENTATION_HORIZONTAL, 10));
+        status_label = Gtk::manage(new Gtk::Label("Ready"));
+        status_label->set_halign(Gtk::ALIGN_START);
+        status_box->pack_start(*status_label, true, true);
+
+        progress_bar = Gtk::manage(new Gtk::ProgressBar());
+        progress_bar->set_visible(false);
+        status_box->pack_end(*progress_bar, false, false);
+
+        main_box->pack_start(*status_box, false, false);
+
+        show_all();
+
+        // Apply custom CSS for thicker scrollbars and darker background
+        Glib::RefPtr<Gtk::CssProvider> css_provider = Gtk::CssProvider::create();
+        css_provider->load_from_data(
+            "window {"
+            "  background-color: #e0e0e0;"
+            "}"
+            "scrolledwindow scrollbar {"
+            "  min-width: 20px;"
+            "  min-height: 20px;"
+            "}"
+            "scrolledwindow scrollbar slider {"
+            "  min-width: 20px;"
+            "  min-height: 20px;"
+            "}"
+        );
+        Glib::RefPtr<Gdk::Screen> screen = Gdk::Screen::get_default();
+        Gtk::StyleContext::add_provider_for_screen(
+            screen, css_provider, GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+
+        // Shown for rows where no favicon could be found
+        fallback_icon = Gdk::Pixbuf::create(Gdk::COLORSPACE_RGB, true, 8, 32, 32);
+        fallback_icon->fill(0x80808080); // Gray with alpha
+
+        // Start queued fetches when another window frees a slot
+        fetch_engine.signal_capacity_available.connect(sigc::mem_fun(*this, &UrlEditorWindow::pump_fetches));
+
+        // Titles fetched in earlier runs and archived pages, shared with
+        // every other window
+        if (use_session) {
+            fetch_engine.open_stores();
+        }
+        metadata_cache = fetch_engine.metadata_cache;
+        page_archive = fetch_engine.page_archive;
+        if (!use_session) return;
+
+        // Restore the list from the previous run
+        std::string session_dir = Glib::build_filename(Glib::get_user_data_dir(), "url-editor");
+        g_mkdir_with_parents(session_dir.c_str(), 0700);
+        session_store = std::make_shared<SessionStore>(Glib::build_filename(session_dir, "session.db"));
+        if (session_store->is_open()) {
+            restore_session();
+        } else {
+            session_store.reset();
+        }
+    }
+
+    ~UrlEditorWindow() {
+        fetch_results->on_ready = nullptr;
+        // Write out the last edits that are still waiting for the debounce timer
+        if (session_save_pending) {
+            save_session(false);
+        }
+        stats_refresh_connection.disconnect();
+        archive_progress_connection.disconnect();
+    }
+
+    // Further windows start empty and keep no session; the saved list
+    // belongs to the first one
+    void on_new_window_clicked() {
+        UrlEditorWindow* window = new UrlEditorWindow(false);
+        window->set_title("URL Editor (new list)");
+        window->delete_when_closed();
+        Glib::RefPtr<Gtk::Application> application = get_application();
+        if (application) {
+            application->add_window(*window);
+        }
+        window->present();
+    }
+
+    // The window deletes itself once hidden and once its fetch and import
+    // threads, which hold a pointer to it, have all reported back
+    void delete_when_closed() {
+        signal_hide().connect([this]() {
+            closing = true;
+            fetch_running = false;
+            browser_queue.clear();
+            // Hidden windows get no frame ticks to drain results with
+            Glib::signal_idle().connect(sigc::mem_fun(*this, &UrlEditorWindow::drain_fetch_results));
+            delete_if_finished();
+        });
+    }
+
+    void delete_if_finished() {
+        if (!closing || threads_running > 0 || delete_pending) return;
+        delete_pending = true;
+        Glib::signal_idle().connect_once([this]() { delete this; });
+    }
+
+    // Replaces the text field and loads it, as if pasted and loaded by hand
+    void load_text(const Glib::ustring& text, bool mode2 = true) {
+        (mode2 ? mode2_radio : mode1_radio)->set_active(true);
+        syncing_buffer = true;
+        url_text_view->get_buffer()->set_text(text);
+        syncing_buffer = false;
+        reload_from_text(text);
+    }
+
+    bool fetch_in_progress() const { return fetch_running; }
+
+    // Saved rows are still being added to the list
+    bool restore_in_progress() const { return !restore_entries.empty(); }
+
+    // Memory used by the entry data, not counting the row widgets
+    EntryStore::MemoryUsage entry_memory_usage() const { return entry_store.memory_usage(); }
+
+    // Third favicon source after /favicon.ico and /favicon.png; the host
+    // name and "&sz=32" are appended
+    void set_favicon_service(const std::string& url_prefix) { favicon_service = url_prefix; }
+
+private:
+    // Single-row actions (move, delete, copy) work on the most recently
+    // selected row that is still selected; opening works on all of them
+    void on_selected_rows_changed() {
+        std::vector<Gtk::ListBoxRow*> rows = list_box->get_selected_rows();
+        Gtk::ListBoxRow* row = rows.empty() ? nullptr : rows.back();
+        if (current_selected_row && std::find(rows.begin(), rows.end(), current_selected_row) != rows.end()) {
+            row = current_selected_row;
+        }
+        if (row != current_selected_row) {
+            on_row_selected(row);
+        } else {
+            update_button_states(row);
+        }
+        open_browser_button->set_label(rows.size() > 1
+            ? Glib::ustring::compose("Open %1 in browser", rows.size())
+            : Glib::ustring("Open in browser"));
+    }
+
+    // Replaces the selection with row
+    void select_only(Gtk::ListBoxRow& row) {
+        list_box->unselect_all();
+        list_box->select_row(row);
+    }
+
+    void on_row_selected(Gtk::ListBoxRow* row) {
+        // Store the currently selected row
+        current_selected_row = row;
+
+        // Fetch the selected row ahead of everything else
+        if (row) {
+            UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
+            if (url_row) {
+                fetch_scheduler.set_selected(url_row->get_id());
+                pump_fetches();
+            }
+        }
+
+        // This is called when selection changes via user interaction
+        // But we also call update_button_states manually after moves
+        update_button_states(row);
+    }
+
+    void on_move_up_clicked() {
+        flush_live_sync();
+
+        Gtk::ListBoxRow* selected_row = current_selected_row;
+        if (!selected_row) return;
+
+        int current_index = selected_row->get_index();
         if (current_index <= 0) return; // Already at top
 
-        // Get all children
-        std::vector<Gtk::Widget*> children = list_box->get_children();
-        if (current_index > 0 && current_index < (int)children.size()) {
-            // Get the widget to move (the selected row)
-            Gtk::Widget* widget_to_move = children[current_index];
-            Gtk::ListBoxRow* row_to_move = dynamic_cast<Gtk::ListBoxRow*>(widget_to_move);
-            if (!row_to_move) return;
+        // Get all children
+        std::vector<Gtk::Widget*> children = list_box->get_children();
+        if (current_index > 0 && current_index < (int)children.size()) {
+            // Get the widget to move (the selected row)
+            Gtk::Widget* widget_to_move = children[current_index];
+            Gtk::ListBoxRow* row_to_move = dynamic_cast<Gtk::ListBoxRow*>(widget_to_move);
+            if (!row_to_move) return;
+
+            // Remove it from current position
+            list_box->remove(*widget_to_move);
+
+            // Insert at new position (one position up)
+            int new_index = current_index - 1;
+            list_box->insert(*widget_to_move, new_index);
+
+            // Ensure it's visible
+            list_box->show_all();
+
+            // Re-select by getting the row at the new index
+            // This ensures we have the correct row reference
+            Gtk::ListBoxRow* row_at_new_index = list_box->get_row_at_index(new_index);
+            Gtk::ListBoxRow* row_to_select = row_at_new_index ? row_at_new_index : row_to_move;
+
+            if (row_to_select) {
+                select_only(*row_to_select);
+                row_to_select->grab_focus();
+                // Update our stored reference
+                current_selected_row = row_to_select;
+                update_button_states(row_to_select);
+            }
+
+            // Update row numbers after move
+            update_row_numbers();
+            schedule_session_save();
+            sync_rows_swapped(current_index, new_index);
+
+            // Use idle callback to ensure selection is properly maintained
+            // This processes pending events and ensures GTK updates its internal state
+            Glib::signal_idle().connect_once(sigc::track_obj([this, new_index, row_to_select]() {
+                Gtk::ListBoxRow* row = list_box->get_row_at_index(new_index);
+                if (row) {
+                    select_only(*row);
+                    current_selected_row = row;
+                    update_button_states(row);
+                } else if (row_to_select) {
+                    // Fallback to the row we selected earlier
+                    select_only(*row_to_select);
+                    current_selected_row = row_to_select;
+                    update_button_states(row_to_select);
+                }
+            }, *this));
+        }
+    }
+
+    void on_move_down_clicked() {
+        flush_live_sync();
+
+        Gtk::ListBoxRow* selected_row = current_selected_row;
+        if (!selected_row) return;
+
+        int current_index = selected_row->get_index();
+        std::vector<Gtk::Widget*> children = list_box->get_children();
+
+        if (current_index >= 0 && current_index < (int)children.size() - 1) {
+            // Get the widget to move (the selected row)
+            Gtk::Widget* widget_to_move = children[current_index];
+            Gtk::ListBoxRow* row_to_move = dynamic_cast<Gtk::ListBoxRow*>(widget_to_move);
+            if (!row_to_move) return;
+
+            // Remove it from current position
+            list_box->remove(*widget_to_move);
+
+            // Insert at new position (one position down)
+            int new_index = current_index + 1;
+            list_box->insert(*widget_to_move, new_index);
+
+            // Ensure it's visible
+            list_box->show_all();
+
+            // Re-select by getting the row at the new index
+            // This ensures we have the correct row reference
+            Gtk::ListBoxRow* row_at_new_index = list_box->get_row_at_index(new_index);
+            Gtk::ListBoxRow* row_to_select = row_at_new_index ? row_at_new_index : row_to_move;
+
+            if (row_to_select) {
+                select_only(*row_to_select);
+                row_to_select->grab_focus();
+                // Update our stored reference
+                current_selected_row = row_to_select;
+                update_button_states(row_to_select);
+            }
+
+            // Update row numbers after move
+            update_row_numbers();
+            schedule_session_save();
+            sync_rows_swapped(current_index, new_index);
+
+            // Use idle callback to ensure selection is properly maintained
+            // This processes pending events and ensures GTK updates its internal state
+            Glib::signal_idle().connect_once(sigc::track_obj([this, new_index, row_to_select]() {
+                Gtk::ListBoxRow* row = list_box->get_row_at_index(new_index);
+                if (row) {
+                    select_only(*row);
+                    current_selected_row = row;
+                    update_button_states(row);
+                } else if (row_to_select) {
+                    // Fallback to the row we selected earlier
+                    select_only(*row_to_select);
+                    current_selected_row = row_to_select;
+                    update_button_states(row_to_select);
+                }
+            }, *this));
+        }
+    }
+
+    void update_button_states(Gtk::ListBoxRow* row) {
+        if (!row) {
+            move_up_button->set_sensitive(false);
+            move_down_button->set_sensitive(false);
+            delete_button->set_sensitive(false);
+            copy_url_button->set_sensitive(false);
+            open_browser_button->set_sensitive(false);
+            archive_button->set_sensitive(false);
+            return;
+        }
+
+        int index = row->get_index();
+        std::vector<Gtk::Widget*> children = list_box->get_children();
+        int total_items = children.size();
+
+        delete_button->set_sensitive(true);
+        copy_url_button->set_sensitive(true);
+        open_browser_button->set_sensitive(true);
+        archive_button->set_sensitive(page_archive != nullptr);
+        move_up_button->set_sensitive(index > 0);
+        move_down_button->set_sensitive(index >= 0 && index < total_items - 1);
+    }
+
+    void update_url_count() {
+        url_count_label->set_text(Glib::ustring::compose("URLs: %1", rows_by_id.size()));
+
+        EntryStore::MemoryUsage usage = entry_store.memory_usage();
+        url_count_label->set_tooltip_text(Glib::ustring::compose(
+            "Entry storage: %1 KiB, %2 bytes per entry\n%3 hosts, %4 KiB of replaced text awaiting compaction",
+            usage.total_bytes() / 1024, (int)usage.bytes_per_entry(), usage.hosts, usage.wasted_bytes / 1024));
+    }
+
+    Gtk::Widget* create_stats_panel() {
+        stats_panel = Gtk::manage(new Gtk::Box(Gtk::ORIENTATION_VERTICAL, 6));
+        stats_panel->set_border_width(4);
+        stats_panel->set_no_show_all(true);
+
+        stats_group_combo = Gtk::manage(new Gtk::ComboBoxText());
+        stats_group_combo->append("By domain");
+        stats_group_combo->append("By host");
+        stats_group_combo->append("By fetch status");
+        stats_group_combo->append("By scheme");
+        stats_group_combo->set_active(EntryStore::GROUP_DOMAIN);
+        stats_group_combo->signal_changed().connect([this]() {
+            clear_stats_filter();
+            refresh_stats(true);
+        });
+        stats_panel->pack_start(*stats_group_combo, false, false);
+
+        stats_summary_label = Gtk::manage(new Gtk::Label());
+        stats_summary_label->set_halign(Gtk::ALIGN_START);
+        stats_summary_label->set_line_wrap(true);
+        stats_panel->pack_start(*stats_summary_label, false, false);
+
+        stats_model = Gtk::ListStore::create(stats_columns);
+        stats_view = Gtk::manage(new Gtk::TreeView(stats_model));
+        stats_view->append_column("Name", stats_columns.name);
+        stats_view->append_column("URLs", stats_columns.total);
+        stats_view->append_column("Failed", stats_columns.failed);
+        stats_view->append_column("Untitled", stats_columns.untitled);
+        stats_view->get_column(0)->set_expand(true);
+        stats_view->get_selection()->signal_changed().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_stats_selection_changed));
+
+        Gtk::ScrolledWindow* stats_scrolled = Gtk::manage(new Gtk::ScrolledWindow());
+        stats_scrolled->set_policy(Gtk::POLICY_NEVER, Gtk::POLICY_AUTOMATIC);
+        stats_scrolled->set_min_content_width(260);
+        stats_scrolled->add(*stats_view);
+        stats_panel->pack_start(*stats_scrolled, true, true);
+
+        stats_show_all_button = Gtk::manage(new Gtk::Button("Show all"));
+        stats_show_all_button->set_sensitive(false);
+        stats_show_all_button->signal_clicked().connect(sigc::mem_fun(*this, &UrlEditorWindow::clear_stats_filter));
+        stats_panel->pack_start(*stats_show_all_button, false, false);
+
+        return stats_panel;
+    }
+
+    void on_stats_toggled() {
+        if (stats_check->get_active()) {
+            stats_panel->show_all();
+            refresh_stats(true);
+            // The store keeps the counts current; the panel only polls for changes
+            stats_refresh_connection = Glib::signal_timeout().connect([this]() {
+                refresh_stats(false);
+                return true;
+            }, 500);
+        } else {
+            stats_refresh_connection.disconnect();
+            clear_stats_filter();
+            stats_panel->hide();
+        }
+    }
+
+    void refresh_stats(bool force) {
+        if (!stats_check->get_active()) return;
+        if (!force && entry_store.change_count() == stats_change_count) return;
+        TraceSpan span("stats-refresh");
+        stats_change_count = entry_store.change_count();
+
+        const StatsBucket& totals = entry_store.totals();
+        stats_summary_label->set_text(Glib::ustring::compose(
+            "%1 URLs, %2 domains, %3 hosts\n%4 pending, %5 failed, %6 untitled",
+            totals.total, entry_store.domain_count(), entry_store.host_count(),
+            totals.pending, totals.failed, totals.untitled));
+
+        const size_t max_buckets = 500;
+        EntryStore::StatsGroup group = (EntryStore::StatsGroup)stats_group_combo->get_active_row_number();
+        std::vector<EntryStore::StatsRow> buckets = entry_store.top_buckets(group, max_buckets);
+
+        // Rebuilding the model clears the selection, so keep the filter across it
+        updating_stats = true;
+        stats_view->unset_model();
+        stats_model->clear();
+        Gtk::TreeModel::iterator selected;
+        for (const EntryStore::StatsRow& bucket : buckets) {
+            Gtk::TreeModel::Row row = *stats_model->append();
+            row[stats_columns.key] = bucket.key;
+            row[stats_columns.name] = bucket.name;
+            row[stats_columns.total] = bucket.counts.total;
+            row[stats_columns.failed] = bucket.counts.failed;
+            row[stats_columns.untitled] = bucket.counts.untitled;
+            if (stats_filter_active && bucket.key == stats_filter_key) {
+                selected = row;
+            }
+        }
+        stats_view->set_model(stats_model);
+        if (selected) {
+            stats_view->get_selection()->select(selected);
+        }
+        updating_stats = false;
+
+        // Status buckets change as fetches finish; the others are fixed per URL
+        if (stats_filter_active && stats_filter_group == EntryStore::GROUP_STATUS) {
+            list_box->invalidate_filter();
+        }
+    }
+
+    void on_stats_selection_changed() {
+        if (updating_stats) return;
+        Gtk::TreeModel::iterator selected = stats_view->get_selection()->get_selected();
+        if (!selected) return;
+
+        stats_filter_active = true;
+        stats_filter_group = (EntryStore::StatsGroup)stats_group_combo->get_active_row_number();
+        stats_filter_key = (*selected)[stats_columns.key];
+        stats_show_all_button->set_sensitive(true);
+        list_box->set_filter_func([this](Gtk::ListBoxRow* row) {
+            UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
+            return !url_row || entry_store.in_bucket(url_row->get_id(), stats_filter_group, stats_filter_key);
+        });
+        queue_visible_rows_update();
+    }
+
+    void clear_stats_filter() {
+        if (!stats_filter_active) return;
+        stats_filter_active = false;
+        stats_show_all_button->set_sensitive(false);
+        updating_stats = true;
+        stats_view->get_selection()->unselect_all();
+        updating_stats = false;
+        list_box->unset_filter_func();
+        queue_visible_rows_update();
+    }
+
+    void update_row_numbers() {
+        TraceSpan span("renumber");
+        std::vector<Gtk::Widget*> children = list_box->get_children();
+        for (size_t i = 0; i < children.size(); ++i) {
+            Gtk::ListBoxRow* row = dynamic_cast<Gtk::ListBoxRow*>(children[i]);
+            if (row) {
+                UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
+                if (url_row) {
+                    url_row->set_number(i + 1);
+                }
+            }
+        }
+    }
+
+    void on_copy_url_clicked() {
+        Gtk::ListBoxRow* row = current_selected_row;
+        if (!row) return;
+
+        UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
+        if (!url_row) return;
+
+        Glib::ustring url = url_row->get_url();
+        if (url.empty()) return;
+
+        // Get the default clipboard
+        Glib::RefPtr<Gtk::Clipboard> clipboard = Gtk::Clipboard::get(GDK_SELECTION_CLIPBOARD);
+        clipboard->set_text(url);
+
+        // Also set to primary selection (middle-click paste on Linux)
+        Glib::RefPtr<Gtk::Clipboard> primary = Gtk::Clipboard::get(GDK_SELECTION_PRIMARY);
+        primary->set_text(url);
+
+        status_label->set_text("URL copied to clipboard");
+    }
+
+    void on_open_browser_clicked() {
+        std::vector<std::string> urls;
+        for (Gtk::ListBoxRow* row : list_box->get_selected_rows()) {
+            UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
+            if (url_row && !url_row->get_url().empty()) {
+                urls.push_back(url_row->get_url().raw());
+            }
+        }
+        open_urls(urls);
+    }
+
+    void on_delete_clicked() {
+        flush_live_sync();
+
+        Gtk::ListBoxRow* row = current_selected_row;
+        if (!row) return;
+
+        int index = row->get_index();
+        std::vector<Gtk::Widget*> children = list_box->get_children();
+
+        if (index >= 0 && index < (int)children.size()) {
+            UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
+            if (url_row) {
+                sync_row_deleted(url_row->get_id());
+            }
+            remove_url_row(row);
+
+            // Select next item if available, or previous if at end
+            if (index < (int)children.size() - 1) {
+                // Select the item that moved into this position
+                children = list_box->get_children();
+                if (index < (int)children.size()) {
+                    Gtk::ListBoxRow* new_selection = dynamic_cast<Gtk::ListBoxRow*>(children[index]);
+                    if (new_selection) {
+                        select_only(*new_selection);
+                        current_selected_row = new_selection;
+                    }
+                }
+            } else if (index > 0) {
+                // Select the previous item
+                children = list_box->get_children();
+                if (index - 1 < (int)children.size()) {
+                    Gtk::ListBoxRow* new_selection = dynamic_cast<Gtk::ListBoxRow*>(children[index - 1]);
+                    if (new_selection) {
+                        select_only(*new_selection);
+                        current_selected_row = new_selection;
+                    }
+                }
+            } else {
+                // No items left, disable buttons
+                current_selected_row = nullptr;
+                update_button_states(nullptr);
+            }
+
+            list_box->show_all();
+
+            // Update URL count and row numbers
+            update_url_count();
+            update_row_numbers();
+            schedule_session_save();
+        }
+    }
+
+    void on_row_activated(Gtk::ListBoxRow* row) {
+        if (row) {
+            UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
+            if (url_row) {
+                open_url(url_row->get_url());
+            }
+        }
+    }
+
+    bool on_button_press(GdkEventButton* event) {
+        if (event->type == GDK_BUTTON_PRESS && event->button == 3) {
+            // Right click
+            Gtk::ListBoxRow* row = list_box->get_row_at_y((int)event->y);
+            if (row) {
+                show_context_menu(row, event);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool on_key_press(GdkEventKey* event) {
+        // Check if the text view has focus - if so, allow normal text editing
+        if (url_text_view->has_focus()) {
+            return false; // Let the text view handle the key press
+        }
+
+        // Handle Ctrl+N to open another window
+        if ((event->state & GDK_CONTROL_MASK) && event->keyval == GDK_KEY_n) {
+            on_new_window_clicked();
+            return true;
+        }
+
+        // Handle Ctrl+C to copy URL
+        if ((event->state & GDK_CONTROL_MASK) && event->keyval == GDK_KEY_c) {
+            on_copy_url_clicked();
+            return true;
+        }
+
+        // Handle Delete key to delete entry
+        if (event->keyval == GDK_KEY_Delete) {
+            on_delete_clicked();
+            return true;
+        }
+
+        // Handle Enter key to open the selected rows in the browser
+        if (event->keyval == GDK_KEY_Return || event->keyval == GDK_KEY_KP_Enter) {
+            on_open_browser_clicked();
+            return true;
+        }
+
+        return false;
+    }
+
+    void show_context_menu(Gtk::ListBoxRow* row, GdkEventButton* event) {
+        UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
+        if (!url_row) return;
+
+        Gtk::Menu* menu = Gtk::manage(new Gtk::Menu());
+        Gtk::MenuItem* open_item = Gtk::manage(new Gtk::MenuItem("Open URL"));
+        open_item->signal_activate().connect([this, url_row]() {
+            open_url(url_row->get_url());
+        });
+        menu->append(*open_item);
+        if (page_archive && page_archive->contains(url_row->get_url().raw())) {
+            Gtk::MenuItem* archived_item = Gtk::manage(new Gtk::MenuItem("Open archived copy"));
+            archived_item->signal_activate().connect([this, url_row]() {
+                open_archived_copy(url_row->get_url().raw());
+            });
+            menu->append(*archived_item);
+        }
+        menu->show_all();
+        menu->popup(event->button, gdk_event_get_time((GdkEvent*)event));
+    }
+
+    void on_archive_clicked() {
+        if (!page_archive) return;
+        std::vector<std::string> urls;
+        for (Gtk::ListBoxRow* row : list_box->get_selected_rows()) {
+            UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
+            if (url_row && !url_row->get_url().empty()) {
+                urls.push_back(url_row->get_url().raw());
+            }
+        }
+        if (urls.empty()) return;
+
+        // One archiver serves a run of batches; its counters start at zero
+        if (!page_archiver) {
+            page_archiver.reset(new PageArchiver(page_archive, settings.archive_fetch_concurrency,
+                                                 settings.archive_max_page_bytes));
+            archive_progress_connection = Glib::signal_timeout().connect(
+                sigc::mem_fun(*this, &UrlEditorWindow::update_archive_progress), 250);
+        }
+        for (const std::string& url : urls) {
+            page_archiver->add(url);
+        }
+        update_archive_progress();
+    }
+
+    void on_find_similar_clicked() {
+        finish_restore();
+        // The finder runs on a copy; the store is main-thread only
+        auto entries = std::make_shared<std::vector<NearDuplicateFinder::Entry>>();
+        entries->reserve(rows_by_id.size());
+        for (int i = 0; Gtk::ListBoxRow* row = list_box->get_row_at_index(i); ++i) {
+            UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
+            if (!url_row) continue;
+            uint32_t id = url_row->get_id();
+            std::string url = entry_store.url(id);
+            std::string title = entry_store.title(id);
+            if (title == url) {
+                title.clear();
+            }
+            // Compare where short links and redirects actually lead
+            std::string final_url = entry_store.final_url(id);
+            entries->push_back({id, std::move(title), final_url.empty() ? std::move(url) : std::move(final_url)});
+        }
+        if (entries->size() < 2) return;
 
-            // Remove it from current position
-            list_box->remove(*widget_to_move);
+        // Until the results have been dealt with, no row added meanwhile
+        // may take over the id of one deleted meanwhile
+        for (const NearDuplicateFinder::Entry& entry : *entries) {
+            entry_store.hold(entry.id);
+        }
+        find_similar_button->set_sensitive(false);
+        status_label->set_text(Glib::ustring::compose("Looking for similar entries among %1 URLs...", entries->size()));
+        threads_running++;
+        std::thread([this, entries]() {
+            auto clusters = std::make_shared<std::vector<std::vector<uint32_t>>>();
+            {
+                TraceSpan span("find-similar");
+                span.set_count((long)entries->size());
+                *clusters = NearDuplicateFinder().find(*entries);
+            }
+            Glib::signal_idle().connect_once([this, entries, clusters]() {
+                finish_find_similar(*clusters);
+                for (const NearDuplicateFinder::Entry& entry : *entries) {
+                    entry_store.release(entry.id);
+                }
+            });
+        }).detach();
+    }
 
-            // Insert at new position (one position up)
-            int new_index = current_index - 1;
-            list_box->insert(*widget_to_move, new_index);
+    void finish_find_similar(const std::vector<std::vector<uint32_t>>& clusters) {
+        threads_running--;
+        if (closing) {
+            delete_if_finished();
+            return;
+        }
+        find_similar_button->set_sensitive(true);
+        if (clusters.empty()) {
+            status_label->set_text("No similar entries found");
+            return;
+        }
+        status_label->set_text(Glib::ustring::compose("Found %1 groups of similar entries", clusters.size()));
+        show_similar_dialog(clusters);
+    }
 
-            // Ensure it's visible
-            list_box->show_all();
+    // One group per cluster with its first entry ticked; the unticked
+    // entries of all groups can then be deleted at once
+    void show_similar_dialog(const std::vector<std::vector<uint32_t>>& clusters) {
+        Glib::RefPtr<Gtk::TreeStore> model = Gtk::TreeStore::create(similar_columns);
+        for (const std::vector<uint32_t>& cluster : clusters) {
+            // Rows deleted while the finder ran are left out
+            std::vector<UrlRow*> members;
+            for (uint32_t id : cluster) {
+                if (UrlRow* url_row = find_url_row(id)) {
+                    members.push_back(url_row);
+                }
+            }
+            if (members.size() < 2) continue;
+
+            Gtk::TreeModel::Row group = *model->append();
+            group[similar_columns.is_entry] = false;
+            group[similar_columns.title] = Glib::ustring::compose("%1 similar entries", members.size());
+            for (size_t i = 0; i < members.size(); ++i) {
+                Gtk::TreeModel::Row row = *model->append(group.children());
+                row[similar_columns.is_entry] = true;
+                row[similar_columns.keep] = i == 0;
+                row[similar_columns.row_id] = members[i]->get_id();
+                row[similar_columns.title] = members[i]->get_title();
+                row[similar_columns.url] = members[i]->get_url();
+            }
+        }
 
-            // Re-select by getting the row at the new index
-            // This ensures we have the correct row reference
-            Gtk::ListBoxRow* row_at_new_index = list_box->get_row_at_index(new_index);
-            Gtk::ListBoxRow* row_to_select = row_at_new_index ? row_at_new_index : row_to_move;
+        Gtk::Dialog dialog("Similar entries", *this, true);
+        dialog.set_default_size(800, 500);
+        dialog.add_button("_Close", Gtk::RESPONSE_CLOSE);
+        dialog.add_button("_Delete unticked", Gtk::RESPONSE_APPLY);
+
+        Gtk::TreeView* view = Gtk::manage(new Gtk::TreeView(model));
+        Gtk::CellRendererToggle* keep_renderer = Gtk::manage(new Gtk::CellRendererToggle());
+        Gtk::TreeViewColumn* keep_column = view->get_column(view->append_column("Keep", *keep_renderer) - 1);
+        keep_column->add_attribute(keep_renderer->property_active(), similar_columns.keep);
+        keep_column->add_attribute(keep_renderer->property_visible(), similar_columns.is_entry);
+        keep_renderer->signal_toggled().connect([this, model](const Glib::ustring& path) {
+            Gtk::TreeModel::iterator it = model->get_iter(path);
+            if (!it) return;
+            bool keep = (*it)[similar_columns.keep];
+            (*it)[similar_columns.keep] = !keep;
+        });
+        view->append_column("Title", similar_columns.title);
+        view->append_column("URL", similar_columns.url);
+        view->get_column(1)->set_expand(true);
+        view->expand_all();
+
+        Gtk::ScrolledWindow* scrolled = Gtk::manage(new Gtk::ScrolledWindow());
+        scrolled->add(*view);
+        dialog.get_content_area()->pack_start(*scrolled, true, true);
+        dialog.show_all_children();
+        if (dialog.run() != Gtk::RESPONSE_APPLY) return;
+
+        std::vector<int> row_ids;
+        model->foreach_iter([this, &row_ids](const Gtk::TreeModel::iterator& it) {
+            bool is_entry = (*it)[similar_columns.is_entry];
+            bool keep = (*it)[similar_columns.keep];
+            if (is_entry && !keep) {
+                row_ids.push_back((*it)[similar_columns.row_id]);
+            }
+            return false;
+        });
+        remove_rows(row_ids);
+        status_label->set_text(Glib::ustring::compose("Deleted %1 similar entries", row_ids.size()));
+    }
 
-            if (row_to_select) {
-                list_box->select_row(*row_to_select);
-                row_to_select->grab_focus();
-                // Update our stored reference
-                current_selected_row = row_to_select;
-                update_button_states(row_to_select);
+    bool update_archive_progress() {
+        if (!page_archiver) return false;
+        long archived = page_archiver->archived();
+        long failed = page_archiver->failed();
+        long total = page_archiver->total();
+        if (!page_archiver->idle()) {
+            status_label->set_text(Glib::ustring::compose("Archiving pages: %1 of %2 (%3 failed)",
+                                                          archived + failed, total, failed));
+            return true;
+        }
+
+        status_label->set_text(Glib::ustring::compose("Archived %1 pages, %2 failed", archived, failed));
+        page_archiver.reset();
+        return false;
+    }
+
+    // Writes the archived body to a file and opens that in the browser. A
+    // <base> element keeps relative links pointing at the live site.
+    void open_archived_copy(const std::string& url) {
+        PageArchive::Page page;
+        if (!page_archive || !page_archive->lookup(url, page)) {
+            status_label->set_text("No archived copy of " + url);
+            return;
+        }
+
+        bool html = page.content_type.empty() || page.content_type.find("html") != std::string::npos;
+        if (html) {
+            std::string base = Glib::Markup::escape_text(page.final_url).raw();
+            page.body.insert(base_tag_position(page.body), "<base href=\"" + base + "\">\n");
+        }
+
+        std::string offline_dir = Glib::build_filename(Glib::get_user_cache_dir(), "url-editor", "offline");
+        g_mkdir_with_parents(offline_dir.c_str(), 0700);
+        gchar* digest = g_compute_checksum_for_string(G_CHECKSUM_SHA1, url.c_str(), -1);
+        std::string path = Glib::build_filename(offline_dir, std::string(digest) + (html ? ".html" : ""));
+        g_free(digest);
+        try {
+            Glib::file_set_contents(path, page.body);
+            open_urls({Glib::filename_to_uri(path)});
+        } catch (const Glib::Error& error) {
+            status_label->set_text("Could not open the archived copy: " + error.what());
+        }
+    }
+
+    // Right after <head>, or else after the doctype; anything before the
+    // doctype would put the page in quirks mode
+    static size_t base_tag_position(const std::string& html) {
+        std::string start = html.substr(0, 4096);
+        for (char& c : start) {
+            c = g_ascii_tolower(c);
+        }
+        for (const char* tag : {"<head", "<!doctype"}) {
+            size_t found = start.find(tag);
+            size_t length = std::strlen(tag);
+            // "<head" must not match "<header"
+            if (found != std::string::npos && (tag[1] == '!' || start[found + length] == '>' ||
+                                               g_ascii_isspace(start[found + length]))) {
+                size_t end = start.find('>', found);
+                if (end != std::string::npos) return end + 1;
             }
+        }
+        return 0;
+    }
 
-            // Update row numbers after move
+    void open_url(const Glib::ustring& url) {
+        if (url.empty()) return;
+        open_urls({url.raw()});
+    }
+
+    // Queues URLs for the browser. They are launched browser_batch_size at
+    // a time, each batch as one process, browser_batch_interval_ms apart.
+    void open_urls(const std::vector<std::string>& urls) {
+        size_t queued = 0;
+        for (const std::string& url : urls) {
+            // Ensure URL has a scheme
+            std::string target = url.find("://") == std::string::npos ? "http://" + url : url;
+            if (!url.empty() && url[0] != '-' && browser_safe_url(target)) {
+                browser_queue.push_back(target);
+                queued++;
+            }
+        }
+        if (queued < urls.size()) {
+            status_label->set_text(Glib::ustring::compose("Skipped %1 URLs that are not web pages or files",
+                                                          urls.size() - queued));
+        }
+        browser_queue_total += queued;
+        if (queued > 0 && !browser_launch_pending) {
+            launch_browser_batch();
+        }
+    }
+
+    // List entries come from imports, watched files and other processes;
+    // only web pages and local files go to the browser, so nothing in the
+    // list can pass itself off as a command-line option
+    static bool browser_safe_url(const std::string& url) {
+        if (url.empty() || url[0] == '-') return false;
+        gchar* scheme = g_uri_parse_scheme(url.c_str());
+        bool safe = scheme && (g_ascii_strcasecmp(scheme, "http") == 0 || g_ascii_strcasecmp(scheme, "https") == 0 ||
+                               g_ascii_strcasecmp(scheme, "file") == 0);
+        g_free(scheme);
+        return safe;
+    }
+
+    void launch_browser_batch() {
+        browser_launch_pending = false;
+        if (browser_queue.empty()) {
+            browser_queue_total = 0;
+            return;
+        }
+
+        size_t count = std::min<size_t>(browser_queue.size(), settings.browser_batch_size);
+        std::vector<std::string> batch(browser_queue.begin(), browser_queue.begin() + count);
+        browser_queue.erase(browser_queue.begin(), browser_queue.begin() + count);
+
+        std::string error;
+        if (!launch_browser(batch, error)) {
+            g_warning("Failed to open URLs: %s", error.c_str());
+            status_label->set_text("Failed to open URLs in the browser");
+            browser_queue.clear();
+            browser_queue_total = 0;
+            return;
+        }
+
+        size_t opened = browser_queue_total - browser_queue.size();
+        status_label->set_text(Glib::ustring::compose("Opened %1 of %2 URLs in the browser", opened, browser_queue_total));
+        if (!browser_queue.empty()) {
+            browser_launch_pending = true;
+            Glib::signal_timeout().connect_once(sigc::mem_fun(*this, &UrlEditorWindow::launch_browser_batch),
+                                                (unsigned int)settings.browser_batch_interval_ms);
+        } else {
+            browser_queue_total = 0;
+        }
+    }
+
+    // Starts one browser process for all of urls. The URLs are passed as
+    // separate arguments, never through a shell.
+    bool launch_browser(const std::vector<std::string>& urls, std::string& error) {
+        GError* gerror = nullptr;
+        bool ok = false;
+
+        if (settings.browser_command.empty()) {
+            // The desktop's default browser, which takes every URL in one launch
+            GAppInfo* app = g_app_info_get_default_for_uri_scheme("https");
+            if (!app) {
+                error = "No default browser";
+                return false;
+            }
+            GList* uris = nullptr;
+            for (const std::string& url : urls) {
+                uris = g_list_append(uris, (gpointer)url.c_str());
+            }
+            ok = g_app_info_launch_uris(app, uris, nullptr, &gerror);
+            g_list_free(uris);
+            g_object_unref(app);
+        } else {
+            gint argc = 0;
+            gchar** command_argv = nullptr;
+            if (g_shell_parse_argv(settings.browser_command.c_str(), &argc, &command_argv, &gerror)) {
+                std::vector<gchar*> argv(command_argv, command_argv + argc);
+                argv.push_back((gchar*)"--"); // End of options
+                for (const std::string& url : urls) {
+                    argv.push_back((gchar*)url.c_str());
+                }
+                argv.push_back(nullptr);
+                ok = g_spawn_async(nullptr, argv.data(), nullptr, G_SPAWN_SEARCH_PATH, nullptr, nullptr, nullptr, &gerror);
+                g_strfreev(command_argv);
+            }
+        }
+
+        if (gerror) {
+            error = gerror->message;
+            g_error_free(gerror);
+        }
+        return ok;
+    }
+
+    void on_load_clicked() {
+        load_urls();
+    }
+
+    void on_save_clicked() {
+        save_urls();
+    }
+
+    void on_refresh_clicked() {
+        finish_restore();
+        // Refetch every icon instead of reusing the ones already downloaded
+        icon_cache.clear();
+        saved_icon_keys.clear();
+        for (auto& row : rows_by_id) {
+            row.second->set_status(FETCH_PENDING);
+        }
+        download_favicons();
+    }
+
+    void on_import_clicked() {
+        Gtk::FileChooserDialog dialog(*this, "Import bookmarks", Gtk::FILE_CHOOSER_ACTION_OPEN);
+        dialog.add_button("_Cancel", Gtk::RESPONSE_CANCEL);
+        dialog.add_button("_Import", Gtk::RESPONSE_OK);
+
+        Glib::RefPtr<Gtk::FileFilter> bookmarks_filter = Gtk::FileFilter::create();
+        bookmarks_filter->set_name("Bookmarks (HTML, Chromium Bookmarks, Firefox places.sqlite)");
+        bookmarks_filter->add_pattern("*.html");
+        bookmarks_filter->add_pattern("*.htm");
+        bookmarks_filter->add_pattern("*.json");
+        bookmarks_filter->add_pattern("Bookmarks");
+        bookmarks_filter->add_pattern("*.sqlite");
+        dialog.add_filter(bookmarks_filter);
+
+        Glib::RefPtr<Gtk::FileFilter> all_filter = Gtk::FileFilter::create();
+        all_filter->set_name("All files");
+        all_filter->add_pattern("*");
+        dialog.add_filter(all_filter);
+
+        if (dialog.run() != Gtk::RESPONSE_OK) return;
+        import_file(dialog.get_filename());
+    }
+
+    // Parses the file on a worker thread and appends rows in batches, so
+    // the UI stays responsive and no full tree of the file is ever built
+    void import_file(const std::string& path) {
+        status_label->set_text("Importing " + Glib::filename_display_basename(path) + "...");
+        import_button->set_sensitive(false);
+        threads_running++;
+
+        std::thread([this, path]() {
+            const size_t batch_size = 500;
+            auto batch = std::make_shared<std::vector<ImportedEntry>>();
+
+            ImportCallback emit = [this, &batch, batch_size](ImportedEntry&& entry) {
+                batch->push_back(std::move(entry));
+                if (batch->size() >= batch_size) {
+                    auto full_batch = batch;
+                    Glib::signal_idle().connect_once([this, full_batch]() { apply_imported_batch(*full_batch); });
+                    batch = std::make_shared<std::vector<ImportedEntry>>();
+                }
+            };
+
+            std::string error;
+            bool ok;
+            {
+                TraceSpan span("import-parse");
+                ok = import_bookmarks(path, emit, error);
+            }
+            Glib::signal_idle().connect_once([this, batch, ok, error]() {
+                apply_imported_batch(*batch);
+                finish_import(ok, error);
+            });
+        }).detach();
+    }
+
+    void apply_imported_batch(std::vector<ImportedEntry>& batch) {
+        TraceSpan span("populate");
+        span.set_count((long)batch.size());
+        std::vector<int> fetch_rows;
+        for (ImportedEntry& entry : batch) {
+            // Bookmark files are not always valid UTF-8
+            for (std::string* text : {&entry.title, &entry.url}) {
+                if (!g_utf8_validate(text->data(), text->size(), nullptr)) {
+                    gchar* valid = g_utf8_make_valid(text->data(), text->size());
+                    *text = valid;
+                    g_free(valid);
+                }
+            }
+
+            Glib::ustring url = entry.url;
+            Glib::ustring title = entry.title.empty() ? url : Glib::ustring(entry.title);
+            UrlRow* url_row = add_url_entry(title, url);
+
+            // Rows that came with an icon and a title never hit the network
+            Glib::RefPtr<Gdk::Pixbuf> icon;
+            if (!entry.icon.empty()) {
+                icon = pixbuf_from_data((const guint8*)entry.icon.data(), entry.icon.size());
+            }
+            if (icon) {
+                set_favicon(url_row->get_id(), icon, extract_base_url(entry.url));
+            }
+            if (!icon || title == url) {
+                fetch_rows.push_back(url_row->get_id());
+            }
+        }
+
+        update_url_count();
+        queue_row_fetches(fetch_rows);
+    }
+
+    void finish_import(bool ok, const std::string& error) {
+        threads_running--;
+        if (closing) {
+            delete_if_finished();
+            return;
+        }
+        import_button->set_sensitive(true);
+        update_row_numbers();
+        if (!ok) {
+            status_label->set_text("Import failed: " + error);
+            return;
+        }
+        status_label->set_text(Glib::ustring::compose("Imported bookmarks, %1 URLs in list", rows_by_id.size()));
+
+        // Imported rows are not in the text field; bring it up to date so
+        // live sync doesn't drop them on the next edit
+        if (live_sync_check->get_active()) {
+            save_urls(mode2_radio->get_active());
+        } else {
+            line_map_valid = false;
+        }
+    }
+
+
+    void on_watch_clicked() {
+        if (file_tailer) {
+            stop_watching();
+            return;
+        }
+
+        Gtk::FileChooserDialog dialog(*this, "Watch URL list", Gtk::FILE_CHOOSER_ACTION_OPEN);
+        dialog.add_button("_Cancel", Gtk::RESPONSE_CANCEL);
+        dialog.add_button("_Watch", Gtk::RESPONSE_OK);
+        if (dialog.run() != Gtk::RESPONSE_OK) return;
+        watch_file(dialog.get_filename());
+    }
+
+    // Makes the list follow a file in the selected input format: loaded
+    // from it once, then extended by every line appended to it
+    void watch_file(const std::string& path) {
+        try {
+            watch_monitor = Gio::File::create_for_path(path)->monitor_file();
+        } catch (const Glib::Error& error) {
+            status_label->set_text("Cannot watch " + Glib::filename_display_basename(path) + ": " + error.what());
+            return;
+        }
+        watch_monitor->signal_changed().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_watched_file_changed));
+        file_tailer.reset(new FileTailer(path, mode2_radio->get_active()));
+        watch_button->set_label("Stop watching");
+        read_watched_file();
+    }
+
+    void stop_watching() {
+        if (watch_monitor) {
+            watch_monitor->cancel();
+            watch_monitor.reset();
+        }
+        file_tailer.reset();
+        watch_button->set_label("Watch file...");
+        status_label->set_text("Stopped watching");
+    }
+
+    void on_watched_file_changed(const Glib::RefPtr<Gio::File>&, const Glib::RefPtr<Gio::File>&,
+                                 Gio::FileMonitorEvent event) {
+        if (event == Gio::FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED || watch_read_pending) return;
+        watch_read_pending = true;
+
+        // A writer appending in small pieces sends a burst of events
+        Glib::signal_timeout().connect_once(sigc::track_obj([this]() {
+            watch_read_pending = false;
+            read_watched_file();
+        }, *this), 100);
+    }
+
+    void read_watched_file() {
+        if (!file_tailer) return;
+        TraceSpan span("watch-read");
+        std::vector<UrlEntry> entries;
+        FileTailer::Result result = file_tailer->read(entries);
+        span.set_count((long)entries.size());
+        Glib::ustring name = Glib::filename_display_basename(file_tailer->file_path());
+
+        std::vector<int> added_rows;
+        switch (result) {
+        case FileTailer::UNCHANGED:
+            return;
+        case FileTailer::FAILED:
+            // Deleted or being replaced; the next change event retries
+            status_label->set_text(Glib::ustring::compose("Watching %1: file cannot be read", name));
+            return;
+        case FileTailer::REWRITTEN:
+            // Diffed against the list, so rows still in the file keep their state
+            added_rows = apply_parsed_entries(entries);
             update_row_numbers();
+            status_label->set_text(Glib::ustring::compose("Watching %1: loaded %2 URLs (%3 new)",
+                                                          name, entries.size(), added_rows.size()));
 
-            // Use idle callback to ensure selection is properly maintained
-            // This processes pending events and ensures GTK updates its internal state
-            Glib::signal_idle().connect_once([this, new_index, row_to_select]() {
-                Gtk::ListBoxRow* row = list_box->get_row_at_index(new_index);
-                if (row) {
-                    list_box->select_row(*row);
-                    current_selected_row = row;
-                    update_button_states(row);
-                } else if (row_to_select) {
-                    // Fallback to the row we selected earlier
-                    list_box->select_row(*row_to_select);
-                    current_selected_row = row_to_select;
-                    update_button_states(row_to_select);
+            // Bring the text field up to date so live sync doesn't drop the rows
+            if (live_sync_check->get_active()) {
+                save_urls(mode2_radio->get_active());
+            } else {
+                line_map_valid = false;
+            }
+            break;
+        case FileTailer::APPENDED:
+            added_rows = append_entries(entries);
+            status_label->set_text(Glib::ustring::compose("Watching %1: %2 URLs added, %3 in list",
+                                                          name, added_rows.size(), rows_by_id.size()));
+            break;
+        }
+        update_url_count();
+        queue_row_fetches(added_rows);
+    }
+
+    // Adds rows at the end of the list, and their lines at the end of the
+    // text field under live sync. Returns the new row ids; fetching them
+    // is up to the caller.
+    std::vector<int> append_entries(const std::vector<UrlEntry>& entries) {
+        TraceSpan span("populate");
+        span.set_count((long)entries.size());
+        flush_live_sync();
+        std::vector<int> added_rows;
+        added_rows.reserve(entries.size());
+        for (const UrlEntry& entry : entries) {
+            added_rows.push_back(add_url_entry(entry.title, entry.url)->get_id());
+        }
+        if (live_sync_active()) {
+            sync_rows_appended(added_rows);
+        } else if (live_sync_check->get_active()) {
+            // Mode 1 text is re-diffed on the next edit, which would drop
+            // rows missing from it
+            save_urls(mode2_radio->get_active());
+        } else {
+            line_map_valid = false;
+        }
+        return added_rows;
+    }
+
+    // A "-" argument: lines read from the sending process's stdin
+    struct StdinSubmission {
+        Glib::RefPtr<Gio::ApplicationCommandLine> command_line;
+        Glib::RefPtr<Gio::InputStream> stream;
+        UrlLineParser parser{true};
+        std::string pending_line;
+    };
+
+    // Handles a command line sent to the running instance (including the
+    // first one): URL arguments ("URL" or "URL # Title"), and "-" to read
+    // such lines from the sender's stdin. Without either the window is
+    // raised. The sender waits until its URLs are queued.
+    void submit_command_line(const Glib::RefPtr<Gio::ApplicationCommandLine>& command_line) {
+        std::vector<std::string> arguments = command_line->get_arguments();
+        std::vector<UrlEntry> entries;
+        UrlLineParser parser(true);
+        bool read_stdin = false;
+        for (size_t i = 1; i < arguments.size(); ++i) {
+            if (arguments[i] == "-") {
+                read_stdin = true;
+            } else {
+                parser.feed(arguments[i], entries);
+            }
+        }
+        if (!read_stdin && entries.empty()) {
+            present();
+            return;
+        }
+        submit_entries(std::move(entries));
+
+        Glib::RefPtr<Gio::InputStream> stream = read_stdin ? command_line->get_stdin() : Glib::RefPtr<Gio::InputStream>();
+        if (stream) {
+            auto submission = std::make_shared<StdinSubmission>();
+            submission->command_line = command_line;
+            submission->stream = stream;
+            read_submission(submission);
+        }
+    }
+
+    // Submissions arriving close together become one insert and one
+    // batch of fetches
+    void submit_entries(std::vector<UrlEntry>&& entries) {
+        if (entries.empty()) return;
+        submitted_entries.insert(submitted_entries.end(), std::make_move_iterator(entries.begin()),
+                                 std::make_move_iterator(entries.end()));
+        submission_count++;
+        if (submission_flush_pending) return;
+        submission_flush_pending = true;
+        Glib::signal_timeout().connect_once(sigc::mem_fun(*this, &UrlEditorWindow::flush_submissions), 50);
+    }
+
+    void flush_submissions() {
+        submission_flush_pending = false;
+        std::vector<UrlEntry> entries;
+        entries.swap(submitted_entries);
+        std::vector<int> added_rows = append_entries(entries);
+        update_url_count();
+        status_label->set_text(Glib::ustring::compose("Received %1 URLs in %2 submissions, %3 in list",
+                                                      added_rows.size(), submission_count, rows_by_id.size()));
+        submission_count = 0;
+        queue_row_fetches(added_rows);
+    }
+
+    void read_submission(std::shared_ptr<StdinSubmission> submission) {
+        submission->stream->read_bytes_async(64 * 1024, sigc::track_obj([this, submission](Glib::RefPtr<Gio::AsyncResult>& result) {
+            Glib::RefPtr<Glib::Bytes> bytes;
+            try {
+                bytes = submission->stream->read_bytes_finish(result);
+            } catch (const Glib::Error& error) {
+                submission->command_line->printerr("url-editor: reading stdin failed: " + error.what() + "\n");
+                submission->command_line->set_exit_status(1);
+            }
+
+            gsize size = 0;
+            const char* data = bytes ? (const char*)bytes->get_data(size) : nullptr;
+            std::vector<UrlEntry> entries;
+            if (size > 0) {
+                submission->pending_line.append(data, size);
+                size_t line_start = 0;
+                size_t newline;
+                while ((newline = submission->pending_line.find('\n', line_start)) != std::string::npos) {
+                    submission->parser.feed(submission->pending_line.substr(line_start, newline - line_start), entries);
+                    line_start = newline + 1;
+                }
+                submission->pending_line.erase(0, line_start);
+                submit_entries(std::move(entries));
+                read_submission(submission);
+                return;
+            }
+
+            // End of input (or an error); dropping the last reference to
+            // the command line lets the sender exit
+            submission->parser.feed(submission->pending_line, entries);
+            submit_entries(std::move(entries));
+        }, *this));
+    }
+
+    void load_urls() {
+        // Get text from text view
+        Glib::RefPtr<Gtk::TextBuffer> buffer = url_text_view->get_buffer();
+        Glib::ustring text = buffer->get_text();
+
+        if (text.empty()) {
+            status_label->set_text("Error: Please paste URLs into the text field");
+            return;
+        }
+
+        reload_from_text(text);
+    }
+
+    // Mode 2: URLs only with # title; -1 follows the mode buttons
+    void reload_from_text(const Glib::ustring& text, int mode2_override = -1) {
+        TraceSpan span("load-text");
+        bool mode2 = mode2_override < 0 ? mode2_radio->get_active() : mode2_override != 0;
+        std::vector<UrlEntry> url_entries;
+        {
+            TraceSpan parse_span("parse");
+            url_entries = parse_url_text(text.raw(), mode2);
+            parse_span.set_count((long)url_entries.size());
+        }
+        std::vector<int> added_rows = apply_parsed_entries(url_entries);
+
+        status_label->set_text(Glib::ustring::compose("Loaded %1 URLs (%2 new)", url_entries.size(), added_rows.size()));
+        list_box->show_all();
+
+        // Update URL count and row numbers
+        update_url_count();
+        update_row_numbers();
+
+        // The list now mirrors the text line by line
+        if (mode2) {
+            rebuild_line_map(text.raw());
+        } else {
+            line_map_valid = false;
+        }
+
+        // Start downloading favicons for the rows that were added
+        queue_row_fetches(added_rows);
+    }
+
+    // Makes the list match parsed, reusing rows by URL so their titles,
+    // icons and fetch state survive a reload. Only rows that were added,
+    // removed or moved touch the widgets. Returns the ids of the new rows.
+    std::vector<int> apply_parsed_entries(const std::vector<UrlEntry>& parsed) {
+        finish_restore();
+        TraceSpan span("populate");
+        span.set_count((long)parsed.size());
+        std::vector<Gtk::Widget*> children = list_box->get_children();
+
+        // Existing rows by URL; duplicate URLs are matched in list order
+        std::unordered_map<std::string, std::vector<Gtk::ListBoxRow*>> rows_by_url;
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+            Gtk::ListBoxRow* row = dynamic_cast<Gtk::ListBoxRow*>(*it);
+            UrlRow* url_row = row ? dynamic_cast<UrlRow*>(row->get_child()) : nullptr;
+            if (url_row) {
+                rows_by_url[url_row->get_url().raw()].push_back(row);
+            }
+        }
+
+        std::unordered_map<Gtk::ListBoxRow*, size_t> target_positions;
+        std::vector<size_t> unmatched;
+        for (size_t i = 0; i < parsed.size(); ++i) {
+            auto found = rows_by_url.find(parsed[i].url.raw());
+            if (found == rows_by_url.end() || found->second.empty()) {
+                unmatched.push_back(i);
+                continue;
+            }
+
+            Gtk::ListBoxRow* row = found->second.back();
+            found->second.pop_back();
+            target_positions[row] = i;
+
+            // An explicit title replaces the current one; a bare URL keeps
+            // whatever title was fetched for it
+            UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
+            if (parsed[i].title != parsed[i].url && parsed[i].title != url_row->get_title()) {
+                url_row->set_title(parsed[i].title);
+            }
+        }
+
+        // Drop rows whose URL is no longer in the text
+        for (auto& leftover : rows_by_url) {
+            for (Gtk::ListBoxRow* row : leftover.second) {
+                remove_url_row(row);
+            }
+        }
+
+        // New rows go to the end first and are sorted into place below
+        std::vector<int> added_rows;
+        added_rows.reserve(unmatched.size());
+        for (size_t i : unmatched) {
+            UrlRow* url_row = add_url_entry(parsed[i].title, parsed[i].url);
+            target_positions[dynamic_cast<Gtk::ListBoxRow*>(url_row->get_parent())] = i;
+            added_rows.push_back(url_row->get_id());
+        }
+
+        // Reorder only if needed. A temporary sort function lets GtkListBox
+        // reorder its rows in place without removing and re-adding widgets.
+        children = list_box->get_children();
+        bool in_order = true;
+        for (size_t i = 0; i < children.size() && in_order; ++i) {
+            auto found = target_positions.find(dynamic_cast<Gtk::ListBoxRow*>(children[i]));
+            in_order = found != target_positions.end() && found->second == i;
+        }
+        if (!in_order) {
+            list_box->set_sort_func([&target_positions](Gtk::ListBoxRow* a, Gtk::ListBoxRow* b) {
+                size_t position_a = target_positions[a];
+                size_t position_b = target_positions[b];
+                return position_a < position_b ? -1 : (position_a > position_b ? 1 : 0);
+            });
+            list_box->unset_sort_func();
+        }
+
+        schedule_session_save();
+        return added_rows;
+    }
+
+    void remove_rows(const std::vector<int>& row_ids) {
+        if (row_ids.empty()) return;
+        flush_live_sync();
+        for (int row_id : row_ids) {
+            UrlRow* url_row = find_url_row(row_id);
+            if (!url_row) continue;
+            sync_row_deleted(row_id);
+            remove_url_row(dynamic_cast<Gtk::ListBoxRow*>(url_row->get_parent()));
+        }
+        update_url_count();
+        update_row_numbers();
+        schedule_session_save();
+    }
+
+    // Removes a row and forgets any pending fetch for it
+    void remove_url_row(Gtk::ListBoxRow* row) {
+        UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
+        if (url_row) {
+            rows_by_id.erase(url_row->get_id());
+            // A queued row no longer counts towards the run's progress
+            if (fetch_scheduler.remove(url_row->get_id()) && pending_downloads > 0) {
+                pending_downloads--;
+                if (fetch_running && active_fetches == 0 && fetch_scheduler.empty()) {
+                    pump_fetches(); // Ends the run
                 }
-            });
+            }
+            entry_store.remove(url_row->get_id());
+        }
+        if (row == current_selected_row) {
+            current_selected_row = nullptr;
+            update_button_states(nullptr);
         }
+        list_box->remove(*row);
     }
 
-    void on_move_down_clicked() {
-        // Try to get selected row - use stored reference if get_selected_row() fails
-        Gtk::ListBoxRow* selected_row = list_box->get_selected_row();
-        if (!selected_row) {
-            selected_row = current_selected_row;
-        }
-        if (!selected_row) return;
+    void save_urls(bool mode2 = true) {
+        finish_restore();
+        TraceSpan span("export-text");
+        // Exports in mode 2 format (URL # Title) unless asked for mode 1,
+        // which live sync needs to keep the text parseable. The text goes
+        // into the buffer in chunks as the rows are walked, instead of
+        // building the whole document in memory first.
+        Glib::RefPtr<Gtk::TextBuffer> buffer = url_text_view->get_buffer();
+        syncing_buffer = true;
+        buffer->set_text("");
 
-        int current_index = selected_row->get_index();
-        std::vector<Gtk::Widget*> children = list_box->get_children();
+        const size_t chunk_size = 64 * 1024;
+        std::string chunk;
+        chunk.reserve(chunk_size + 1024);
+        line_rows.clear();
 
-        if (current_index >= 0 && current_index < (int)children.size() - 1) {
-            // Get the widget to move (the selected row)
-            Gtk::Widget* widget_to_move = children[current_index];
-            Gtk::ListBoxRow* row_to_move = dynamic_cast<Gtk::ListBoxRow*>(widget_to_move);
-            if (!row_to_move) return;
+        for (int i = 0; Gtk::ListBoxRow* row = list_box->get_row_at_index(i); ++i) {
+            UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
+            if (!url_row) continue;
 
-            // Remove it from current position
-            list_box->remove(*widget_to_move);
+            if (!line_rows.empty()) {
+                chunk += mode2 ? "\n" : "\n\n";
+            }
+            if (mode2) {
+                chunk += format_mode2_line(url_row->get_title().raw(), url_row->get_url().raw());
+            } else {
+                chunk += (url_row->get_title().empty() ? url_row->get_url() : url_row->get_title()).raw();
+                chunk += '\n';
+                chunk += url_row->get_url().raw();
+            }
+            // Every exported line is one row, in list order (mode 2 only)
+            line_rows.push_back(url_row->get_id());
 
-            // Insert at new position (one position down)
-            int new_index = current_index + 1;
-            list_box->insert(*widget_to_move, new_index);
+            if (chunk.size() >= chunk_size) {
+                buffer->insert(buffer->end(), chunk.data(), chunk.data() + chunk.size());
+                chunk.clear();
+            }
+        }
+        buffer->insert(buffer->end(), chunk.data(), chunk.data() + chunk.size());
+        syncing_buffer = false;
 
-            // Ensure it's visible
-            list_box->show_all();
+        size_t exported = line_rows.size();
+        if (line_rows.empty()) {
+            line_rows.push_back(-1);
+        }
+        line_map_valid = mode2 && mode2_radio->get_active();
+        dirty_first = dirty_last = -1;
+        orphan_rows.clear();
 
-            // Re-select by getting the row at the new index
-            // This ensures we have the correct row reference
-            Gtk::ListBoxRow* row_at_new_index = list_box->get_row_at_index(new_index);
-            Gtk::ListBoxRow* row_to_select = row_at_new_index ? row_at_new_index : row_to_move;
+        status_label->set_text(Glib::ustring::compose("Exported %1 URLs to text field", exported));
+    }
 
-            if (row_to_select) {
-                list_box->select_row(*row_to_select);
-                row_to_select->grab_focus();
-                // Update our stored reference
-                current_selected_row = row_to_select;
-                update_button_states(row_to_select);
+    void on_export_file_clicked() {
+        Gtk::FileChooserDialog dialog(*this, "Export to file", Gtk::FILE_CHOOSER_ACTION_SAVE);
+        dialog.add_button("_Cancel", Gtk::RESPONSE_CANCEL);
+        dialog.add_button("_Export", Gtk::RESPONSE_OK);
+        dialog.set_do_overwrite_confirmation(true);
+        dialog.set_current_name("urls.txt");
+
+        Gtk::Box* options_box = Gtk::manage(new Gtk::Box(Gtk::ORIENTATION_HORIZONTAL, 10));
+        Gtk::ComboBoxText* format_combo = Gtk::manage(new Gtk::ComboBoxText());
+        format_combo->append("URL # Title (mode 2)");
+        format_combo->append("Title / URL lines (mode 1)");
+        format_combo->append("Netscape bookmarks HTML");
+        format_combo->append("JSON Lines");
+        format_combo->append("CSV");
+        format_combo->set_active(EXPORT_MODE2);
+        Gtk::CheckButton* metadata_check = Gtk::manage(new Gtk::CheckButton("Include fetch status, final URL and icon"));
+        options_box->pack_start(*Gtk::manage(new Gtk::Label("Format:")), false, false);
+        options_box->pack_start(*format_combo, false, false);
+        options_box->pack_start(*metadata_check, false, false);
+        options_box->show_all();
+        dialog.set_extra_widget(*options_box);
+
+        // Suggest a matching extension when the format changes
+        format_combo->signal_changed().connect([&dialog, format_combo]() {
+            static const char* const extensions[] = {".txt", ".txt", ".html", ".jsonl", ".csv"};
+            std::string name = dialog.get_current_name();
+            size_t dot = name.rfind('.');
+            if (dot != std::string::npos) {
+                name.erase(dot);
             }
+            dialog.set_current_name(name + extensions[format_combo->get_active_row_number()]);
+        });
 
-            // Update row numbers after move
-            update_row_numbers();
+        if (dialog.run() != Gtk::RESPONSE_OK) return;
+        export_file(dialog.get_filename(), (ExportFormat)format_combo->get_active_row_number(),
+                    metadata_check->get_active());
+    }
 
-            // Use idle callback to ensure selection is properly maintained
-            // This processes pending events and ensures GTK updates its internal state
-            Glib::signal_idle().connect_once([this, new_index, row_to_select]() {
-                Gtk::ListBoxRow* row = list_box->get_row_at_index(new_index);
-                if (row) {
-                    list_box->select_row(*row);
-                    current_selected_row = row;
-                    update_button_states(row);
-                } else if (row_to_select) {
-                    // Fallback to the row we selected earlier
-                    list_box->select_row(*row_to_select);
-                    current_selected_row = row_to_select;
-                    update_button_states(row_to_select);
+    // Streams the list to path through a buffered FILE*. The file is written
+    // next to the target and renamed over it once complete.
+    bool export_file(const std::string& path, ExportFormat format, bool metadata) {
+        finish_restore();
+        TraceSpan span("export-file");
+        std::string temp_path = path + ".part";
+        FILE* file = std::fopen(temp_path.c_str(), "wb");
+        if (!file) {
+            status_label->set_text("Could not write " + Glib::filename_display_basename(path) + ": " +
+                                   Glib::ustring(g_strerror(errno)));
+            return false;
+        }
+        std::setvbuf(file, nullptr, _IOFBF, 256 * 1024);
+
+        BookmarkExporter exporter(file, format, metadata);
+        exporter.begin();
+
+        // Icons are per host, so each data: URI is encoded only once
+        std::unordered_map<std::string, std::string> icon_uris;
+        ExportedEntry entry;
+        size_t exported = 0;
+        for (int i = 0; Gtk::ListBoxRow* row = list_box->get_row_at_index(i); ++i) {
+            UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
+            if (!url_row) continue;
+
+            entry.title = url_row->get_title().raw();
+            entry.url = url_row->get_url().raw();
+            entry.icon_uri = nullptr;
+            if (metadata) {
+                entry.status = url_row->get_status();
+                entry.final_url = url_row->get_final_url();
+                const std::string& icon_key = url_row->get_icon_key();
+                if (!icon_key.empty()) {
+                    auto uri = icon_uris.find(icon_key);
+                    if (uri == icon_uris.end()) {
+                        uri = icon_uris.emplace(icon_key, icon_data_uri(icon_key)).first;
+                    }
+                    if (!uri->second.empty()) {
+                        entry.icon_uri = &uri->second;
+                    }
                 }
-            });
+            }
+            exporter.write(entry);
+            exported++;
+        }
+
+        bool ok = exporter.finish();
+        ok = std::fclose(file) == 0 && ok;
+        if (ok && std::rename(temp_path.c_str(), path.c_str()) != 0) {
+            ok = false;
+        }
+        if (!ok) {
+            std::remove(temp_path.c_str());
+            status_label->set_text("Could not write " + Glib::filename_display_basename(path));
+            return false;
         }
+
+        status_label->set_text(Glib::ustring::compose("Exported %1 URLs to %2", exported,
+                                                      Glib::filename_display_basename(path)));
+        return true;
     }
 
-    void update_button_states(Gtk::ListBoxRow* row) {
-        if (!row) {
-            move_up_button->set_sensitive(false);
-            move_down_button->set_sensitive(false);
-            delete_button->set_sensitive(false);
-            copy_url_button->set_sensitive(false);
-            open_chromium_button->set_sensitive(false);
-            return;
+    // The cached icon for icon_key as a PNG data: URI, empty if there is none
+    std::string icon_data_uri(const std::string& icon_key) {
+        auto cached = icon_cache.find(icon_key);
+        std::string png;
+        if (cached == icon_cache.end() || !pixbuf_to_png(cached->second, png)) {
+            return std::string();
         }
+        gchar* encoded = g_base64_encode((const guchar*)png.data(), png.size());
+        std::string uri = std::string("data:image/png;base64,") + encoded;
+        g_free(encoded);
+        return uri;
+    }
 
-        int index = row->get_index();
-        std::vector<Gtk::Widget*> children = list_box->get_children();
-        int total_items = children.size();
+    // Appends a row. Rows are numbered as they are added; callers adding
+    // many rows update the URL count once at the end.
+    UrlRow* add_url_entry(const Glib::ustring& title, const Glib::ustring& url, int position = -1) {
+        int row_id = (int)entry_store.add(title.raw(), url.raw());
+        UrlRow* row_widget = Gtk::manage(new UrlRow(entry_store, row_id, title, url));
+        Gtk::ListBoxRow* row = Gtk::manage(new Gtk::ListBoxRow());
+        row->add(*row_widget);
+        if (position < 0) {
+            list_box->append(*row);
+        } else {
+            list_box->insert(*row, position);
+        }
+        row->show();
+        rows_by_id[row_id] = row_widget;
+        row_widget->set_number(rows_by_id.size());
 
-        delete_button->set_sensitive(true);
-        copy_url_button->set_sensitive(true);
-        open_chromium_button->set_sensitive(true);
-        move_up_button->set_sensitive(index > 0);
-        move_down_button->set_sensitive(index >= 0 && index < total_items - 1);
+        schedule_session_save();
+        return row_widget;
     }
 
-    void update_url_count() {
-        std::vector<Gtk::Widget*> children = list_box->get_children();
-        int count = children.size();
-        url_count_label->set_text(Glib::ustring::compose("URLs: %1", count));
+    // Restores the list from the previous run. The first rows are built
+    // right away and the rest in idle batches, in list order, so a large
+    // session shows its visible rows at once; icons are decoded when a row
+    // first needs them. Code that needs the whole list calls
+    // finish_restore() first.
+    void restore_session() {
+        TraceSpan span("restore-session");
+        if (!session_store->load(restore_entries, restore_icons) || restore_entries.empty()) {
+            restore_entries.clear();
+            restore_icons.clear();
+            return;
+        }
+        span.set_count((long)restore_entries.size());
+
+        restore_rows(restore_first_rows, 0);
+        if (restore_next < restore_entries.size()) {
+            update_url_count();
+            status_label->set_text(Glib::ustring::compose("Restoring %1 URLs...", restore_entries.size()));
+            restore_connection = Glib::signal_idle().connect(sigc::mem_fun(*this, &UrlEditorWindow::restore_batch));
+        } else {
+            finish_restore();
+        }
     }
 
-    void update_row_numbers() {
-        std::vector<Gtk::Widget*> children = list_box->get_children();
-        for (size_t i = 0; i < children.size(); ++i) {
-            Gtk::ListBoxRow* row = dynamic_cast<Gtk::ListBoxRow*>(children[i]);
-            if (row) {
-                UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
-                if (url_row) {
-                    url_row->set_number(i + 1);
-                }
+    bool restore_batch() {
+        TraceSpan span("restore-batch");
+        size_t first = restore_next;
+        restore_rows(restore_entries.size(), g_get_monotonic_time() + restore_budget_us);
+        span.set_count((long)(restore_next - first));
+        if (restore_next < restore_entries.size()) {
+            update_url_count();
+            return true;
+        }
+        finish_restore();
+        return false;
+    }
+
+    // Builds up to count restored rows, stopping early once the deadline
+    // (if any) has passed
+    void restore_rows(size_t count, gint64 deadline) {
+        size_t end = std::min(restore_entries.size(), restore_next + count);
+        restoring_session = true;
+        while (restore_next < end) {
+            const SessionEntry& entry = restore_entries[restore_next++];
+            UrlRow* url_row = add_url_entry(entry.title, entry.url);
+
+            FetchStatus status = (FetchStatus)entry.status;
+            Glib::RefPtr<Gdk::Pixbuf> icon = status == FETCH_DONE ? restored_icon(entry.icon_key) : Glib::RefPtr<Gdk::Pixbuf>();
+            if (icon) {
+                url_row->set_icon(icon);
+                url_row->set_icon_key(entry.icon_key);
+            } else if (status == FETCH_FAILED) {
+                url_row->set_icon(fallback_icon);
+            } else {
+                status = FETCH_PENDING;
             }
+            url_row->set_status(status);
+            url_row->set_fetched_at(entry.fetched_at);
+            url_row->show_all();
+
+            if (deadline > 0 && g_get_monotonic_time() >= deadline) break;
         }
+        restoring_session = false;
     }
 
-    void on_copy_url_clicked() {
-        Gtk::ListBoxRow* row = list_box->get_selected_row();
-        if (!row) {
-            row = current_selected_row;
+    Glib::RefPtr<Gdk::Pixbuf> restored_icon(const std::string& icon_key) {
+        auto cached = icon_cache.find(icon_key);
+        if (cached != icon_cache.end()) return cached->second;
+        auto saved = restore_icons.find(icon_key);
+        if (saved == restore_icons.end()) return Glib::RefPtr<Gdk::Pixbuf>();
+
+        Glib::RefPtr<Gdk::Pixbuf> pixbuf = pixbuf_from_data((const guint8*)saved->second.data(), saved->second.size());
+        restore_icons.erase(saved);
+        if (pixbuf) {
+            icon_cache[icon_key] = pixbuf;
+            saved_icon_keys.insert(icon_key);
         }
-        if (!row) return;
+        return pixbuf;
+    }
 
-        UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
-        if (!url_row) return;
+    // Builds the rows still waiting to be restored; does nothing once the
+    // restore is complete
+    void finish_restore() {
+        if (restore_entries.empty()) return;
+        restore_connection.disconnect();
+        restore_rows(restore_entries.size(), 0);
 
-        Glib::ustring url = url_row->get_url();
-        if (url.empty()) return;
+        size_t restored = restore_entries.size();
+        std::vector<SessionEntry>().swap(restore_entries);
+        restore_icons.clear();
+        restore_next = 0;
 
-        // Get the default clipboard
-        Glib::RefPtr<Gtk::Clipboard> clipboard = Gtk::Clipboard::get(GDK_SELECTION_CLIPBOARD);
-        clipboard->set_text(url);
+        update_url_count();
+        update_row_numbers();
+        status_label->set_text(Glib::ustring::compose("Restored %1 URLs", restored));
 
-        // Also set to primary selection (middle-click paste on Linux)
-        Glib::RefPtr<Gtk::Clipboard> primary = Gtk::Clipboard::get(GDK_SELECTION_PRIMARY);
-        primary->set_text(url);
+        // Only rows that never finished fetching go back to the network
+        download_favicons(true);
+    }
 
-        status_label->set_text("URL copied to clipboard");
+    // For changes to the list itself: rows added, removed or moved
+    void schedule_session_save() {
+        if (!session_store || restoring_session) return;
+        session_structure_dirty = true;
+        start_session_save_timer();
     }
 
-    void on_open_chromium_clicked() {
-        Gtk::ListBoxRow* row = list_box->get_selected_row();
-        if (!row) {
-            row = current_selected_row;
-        }
-        if (!row) return;
+    // For changes confined to one row (a fetch finished), which are
+    // written without snapshotting the whole list
+    void schedule_row_save(int row_id) {
+        if (!session_store || restoring_session) return;
+        session_dirty_rows.insert(row_id);
+        start_session_save_timer();
+    }
 
-        UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
-        if (!url_row) return;
+    void start_session_save_timer() {
+        if (session_save_pending) return;
+        session_save_pending = true;
 
-        Glib::ustring url = url_row->get_url();
-        if (url.empty()) return;
+        // Coalesce bursts of edits into one write
+        Glib::signal_timeout().connect_once(sigc::track_obj([this]() {
+            session_save_pending = false;
+            save_session(true);
+        }, *this), 1000);
+    }
+
+    // Snapshots what changed on the main thread: the whole list after
+    // structural changes, otherwise just the dirty rows. The database
+    // write itself happens on a worker thread unless in_background is false.
+    void save_session(bool in_background) {
+        if (!session_store) return;
+        // A full save replaces the stored list, so it must see every row
+        finish_restore();
+        TraceSpan span("save-session");
+        session_save_pending = false;
+        if (!session_structure_dirty && session_dirty_rows.empty() && in_background) return;
+
+        auto new_icons = std::make_shared<std::vector<std::pair<std::string, std::string>>>();
+        long sequence = ++session_sequence;
+        std::shared_ptr<SessionStore> store = session_store;
+
+        if (!session_structure_dirty && in_background) {
+            // Positions still match the last full save, which was written
+            // before this one
+            auto rows = std::make_shared<std::vector<std::pair<long, SessionEntry>>>();
+            for (int row_id : session_dirty_rows) {
+                UrlRow* url_row = find_url_row(row_id);
+                Gtk::ListBoxRow* row = url_row ? dynamic_cast<Gtk::ListBoxRow*>(url_row->get_parent()) : nullptr;
+                if (row) {
+                    rows->push_back(std::make_pair((long)row->get_index(), session_entry(url_row, *new_icons)));
+                }
+            }
+            session_dirty_rows.clear();
+            span.set_count((long)rows->size());
+            std::thread([store, sequence, rows, new_icons]() {
+                TraceSpan span("session-write");
+                store->update(sequence, *rows, *new_icons);
+            }).detach();
+            return;
+        }
 
-        std::string url_str = url.raw();
+        auto entries = std::make_shared<std::vector<SessionEntry>>();
+        entries->reserve(rows_by_id.size());
+        for (int i = 0; Gtk::ListBoxRow* row = list_box->get_row_at_index(i); ++i) {
+            UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
+            if (url_row) {
+                entries->push_back(session_entry(url_row, *new_icons));
+            }
+        }
+        session_structure_dirty = false;
+        session_dirty_rows.clear();
+        span.set_count((long)entries->size());
+
+        if (in_background) {
+            std::thread([store, sequence, entries, new_icons]() {
+                TraceSpan span("session-write");
+                store->save(sequence, *entries, *new_icons);
+            }).detach();
+        } else {
+            store->save(sequence, *entries, *new_icons);
+        }
+    }
 
-        // Ensure URL has a scheme
-        if (url_str.find("://") == std::string::npos) {
-            url_str = "http://" + url_str;
+    SessionEntry session_entry(UrlRow* url_row, std::vector<std::pair<std::string, std::string>>& new_icons) {
+        SessionEntry entry;
+        entry.title = url_row->get_title().raw();
+        entry.url = url_row->get_url().raw();
+        entry.icon_key = url_row->get_icon_key();
+        entry.status = url_row->get_status();
+        entry.fetched_at = url_row->get_fetched_at();
+
+        // Icons are encoded once and shared by every row of the same host
+        if (!entry.icon_key.empty() && !saved_icon_keys.count(entry.icon_key)) {
+            auto cached = icon_cache.find(entry.icon_key);
+            std::string png;
+            if (cached != icon_cache.end() && pixbuf_to_png(cached->second, png)) {
+                new_icons.push_back(std::make_pair(entry.icon_key, png));
+                saved_icon_keys.insert(entry.icon_key);
+            }
         }
+        return entry;
+    }
 
-        // Use the specific Chromium path
-        const char* chromium_path = "/home/elias/.local/bin/ungoogled-chromium.AppImage";
+    // Live sync keeps line_rows (the row id shown on each buffer line, -1
+    // for blank lines) up to date as the buffer is edited. Edited lines are
+    // collected into a dirty range and reconciled with the list after a
+    // short pause; list edits patch only the lines of the rows involved.
+    // Line-level sync needs mode 2; in mode 1 the whole text is re-diffed.
 
-        // Build command: chromium_path --new-tab url
-        std::string command = std::string(chromium_path) + " --new-tab \"" + url_str + "\"";
+    bool live_sync_active() const {
+        return live_sync_check->get_active() && mode2_radio->get_active() && line_map_valid;
+    }
 
-        GError* error = nullptr;
-        if (!g_spawn_command_line_async(command.c_str(), &error)) {
-            status_label->set_text("Failed to open URL in Chromium");
-            if (error) {
-                g_warning("Failed to launch Chromium: %s", error->message);
-                g_error_free(error);
-            }
+    void on_live_sync_toggled() {
+        if (!live_sync_check->get_active()) return;
+
+        // Start from whichever side has content; an empty text field would
+        // otherwise wipe a restored list on the first keystroke
+        Glib::ustring text = url_text_view->get_buffer()->get_text();
+        if (text.empty() && !rows_by_id.empty()) {
+            save_urls(mode2_radio->get_active());
         } else {
-            status_label->set_text("Opening URL in Chromium...");
+            reload_from_text(text);
         }
     }
 
-    void on_delete_clicked() {
-        Gtk::ListBoxRow* row = list_box->get_selected_row();
-        if (!row) return;
+    // The text is in the mode that was active until now. Edits still
+    // waiting for the debounce timer are applied in that mode, then the
+    // text is rewritten from the rows in the new one; parsing it with the
+    // new mode would pair up or drop lines and delete their rows.
+    void on_mode_toggled() {
+        if (!live_sync_check->get_active()) return;
+        bool mode2 = mode2_radio->get_active();
+        if (live_sync_pending) {
+            if (mode2) {
+                reload_from_text(url_text_view->get_buffer()->get_text(), 0); // As mode 1
+            } else if (line_map_valid) {
+                sync_dirty_lines();
+            } else {
+                reload_from_text(url_text_view->get_buffer()->get_text(), 1); // As mode 2
+            }
+        }
+        save_urls(mode2);
+    }
 
-        int index = row->get_index();
+    // Applies text edits still waiting for the debounce timer, so list
+    // edits work on up-to-date rows
+    void flush_live_sync() {
+        finish_restore();
+        if (live_sync_active()) {
+            sync_dirty_lines();
+        }
+    }
+
+    void rebuild_line_map(const std::string& text) {
         std::vector<Gtk::Widget*> children = list_box->get_children();
+        std::vector<UrlEntry> parsed;
+        UrlLineParser parser(true);
+        std::istringstream stream(text);
+        std::string line;
+        size_t entry_index = 0;
+
+        line_rows.clear();
+        while (std::getline(stream, line)) {
+            int row_id = -1;
+            if (parser.feed(line, parsed) && entry_index < children.size()) {
+                Gtk::ListBoxRow* row = dynamic_cast<Gtk::ListBoxRow*>(children[entry_index++]);
+                UrlRow* url_row = row ? dynamic_cast<UrlRow*>(row->get_child()) : nullptr;
+                row_id = url_row ? url_row->get_id() : -1;
+            }
+            line_rows.push_back(row_id);
+        }
 
-        if (index >= 0 && index < (int)children.size()) {
-            Gtk::Widget* widget = children[index];
-            list_box->remove(*widget);
+        // A trailing newline leaves an empty last line that getline doesn't report
+        int line_count = url_text_view->get_buffer()->get_line_count();
+        line_rows.resize(std::max(line_count, 1), -1);
+        line_map_valid = entry_index == children.size();
+        dirty_first = dirty_last = -1;
+        orphan_rows.clear();
+    }
 
-            // Select next item if available, or previous if at end
-            if (index < (int)children.size() - 1) {
-                // Select the item that moved into this position
-                children = list_box->get_children();
-                if (index < (int)children.size()) {
-                    Gtk::ListBoxRow* new_selection = dynamic_cast<Gtk::ListBoxRow*>(children[index]);
-                    if (new_selection) {
-                        list_box->select_row(*new_selection);
-                        current_selected_row = new_selection;
+    void mark_lines_dirty(int first, int last) {
+        dirty_first = dirty_first < 0 ? first : std::min(dirty_first, first);
+        dirty_last = std::max(dirty_last, last);
+    }
+
+    void on_buffer_insert(const Gtk::TextBuffer::iterator& pos, const Glib::ustring& text, int) {
+        if (syncing_buffer) return;
+        if (!live_sync_check->get_active()) {
+            line_map_valid = false;
+            return;
+        }
+        if (live_sync_active()) {
+            int line = pos.get_line();
+            int new_lines = std::count(text.raw().begin(), text.raw().end(), '\n');
+            if (new_lines > 0) {
+                // Text inserted at the start of a line pushes that line's row down
+                int at = std::min(pos.starts_line() ? line : line + 1, (int)line_rows.size());
+                line_rows.insert(line_rows.begin() + at, new_lines, -1);
+                if (dirty_first >= at) dirty_first += new_lines;
+                if (dirty_last >= at) dirty_last += new_lines;
+            }
+            mark_lines_dirty(line, line + new_lines);
+        }
+        schedule_live_sync();
+    }
+
+    void on_buffer_erase(const Gtk::TextBuffer::iterator& range_start, const Gtk::TextBuffer::iterator& range_end) {
+        if (syncing_buffer) return;
+        if (!live_sync_check->get_active()) {
+            line_map_valid = false;
+            return;
+        }
+        if (live_sync_active()) {
+            int first = range_start.get_line();
+            int last = std::min(range_end.get_line(), (int)line_rows.size() - 1);
+            if (last > first) {
+                // Lines after the first are merged into it; their rows may
+                // reappear elsewhere (cut and paste) or be removed
+                for (int line = first + 1; line <= last; ++line) {
+                    if (line_rows[line] >= 0) {
+                        orphan_rows.insert(line_rows[line]);
                     }
                 }
-            } else if (index > 0) {
-                // Select the previous item
-                children = list_box->get_children();
-                if (index - 1 < (int)children.size()) {
-                    Gtk::ListBoxRow* new_selection = dynamic_cast<Gtk::ListBoxRow*>(children[index - 1]);
-                    if (new_selection) {
-                        list_box->select_row(*new_selection);
-                        current_selected_row = new_selection;
-                    }
+                line_rows.erase(line_rows.begin() + first + 1, line_rows.begin() + last + 1);
+
+                int removed = last - first;
+                auto shift = [first, last, removed](int line) {
+                    return line <= first ? line : (line <= last ? first : line - removed);
+                };
+                if (dirty_first >= 0) {
+                    dirty_first = shift(dirty_first);
+                    dirty_last = shift(dirty_last);
                 }
-            } else {
-                // No items left, disable buttons
-                current_selected_row = nullptr;
-                update_button_states(nullptr);
             }
+            mark_lines_dirty(first, first);
+        }
+        schedule_live_sync();
+    }
 
-            list_box->show_all();
+    void schedule_live_sync() {
+        if (live_sync_pending) return;
+        live_sync_pending = true;
 
-            // Update URL count and row numbers
-            update_url_count();
-            update_row_numbers();
+        // Wait for a pause in typing
+        Glib::signal_timeout().connect_once(sigc::track_obj([this]() {
+            live_sync_pending = false;
+            if (!live_sync_check->get_active()) return;
+            if (live_sync_active()) {
+                sync_dirty_lines();
+            } else {
+                reload_from_text(url_text_view->get_buffer()->get_text());
+            }
+        }, *this), 300);
+    }
+
+    static std::string get_buffer_line(const Glib::RefPtr<Gtk::TextBuffer>& buffer, int line) {
+        Gtk::TextBuffer::iterator start = buffer->get_iter_at_line(line);
+        Gtk::TextBuffer::iterator end = start;
+        if (!end.ends_line()) {
+            end.forward_to_line_end();
         }
+        return buffer->get_text(start, end).raw();
     }
 
-    void on_row_activated(Gtk::ListBoxRow* row) {
-        if (row) {
-            UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
+    // Position in the list where a row for the given line belongs: right
+    // after the row of the nearest line above it that has one
+    int list_position_for_line(int line) {
+        for (int previous = line - 1; previous >= 0; --previous) {
+            UrlRow* url_row = line_rows[previous] >= 0 ? find_url_row(line_rows[previous]) : nullptr;
             if (url_row) {
-                open_url(url_row->get_url());
+                Gtk::ListBoxRow* row = dynamic_cast<Gtk::ListBoxRow*>(url_row->get_parent());
+                return row ? row->get_index() + 1 : 0;
             }
         }
+        return 0;
     }
 
-    bool on_button_press(GdkEventButton* event) {
-        if (event->type == GDK_BUTTON_PRESS && event->button == 3) {
-            // Right click
-            Gtk::ListBoxRow* row = list_box->get_row_at_y((int)event->y);
-            if (row) {
-                show_context_menu(row, event);
-                return true;
+    // Applies the dirty lines to the list
+    void sync_dirty_lines() {
+        TraceSpan span("live-sync");
+        if (dirty_first < 0 && orphan_rows.empty()) return;
+
+        Glib::RefPtr<Gtk::TextBuffer> buffer = url_text_view->get_buffer();
+        int line_count = buffer->get_line_count();
+        line_rows.resize(line_count, -1);
+        int first = std::max(dirty_first, 0);
+        int last = std::min(dirty_last, line_count - 1);
+        dirty_first = dirty_last = -1;
+
+        // Keep rows whose line still holds the same URL; release the others
+        std::vector<std::pair<int, UrlEntry>> new_lines;
+        for (int line = first; line <= last; ++line) {
+            std::vector<UrlEntry> parsed;
+            UrlLineParser parser(true);
+            parser.feed(get_buffer_line(buffer, line), parsed);
+
+            UrlRow* url_row = line_rows[line] >= 0 ? find_url_row(line_rows[line]) : nullptr;
+            if (url_row && !parsed.empty() && parsed[0].url == url_row->get_url()) {
+                if (parsed[0].title != parsed[0].url && parsed[0].title != url_row->get_title()) {
+                    url_row->set_title(parsed[0].title);
+                }
+                continue;
             }
-        }
-        return false;
-    }
 
-    bool on_key_press(GdkEventKey* event) {
-        // Check if the text view has focus - if so, allow normal text editing
-        if (url_text_view->has_focus()) {
-            return false; // Let the text view handle the key press
+            if (url_row) {
+                orphan_rows.insert(url_row->get_id());
+            }
+            line_rows[line] = -1;
+            if (!parsed.empty()) {
+                new_lines.push_back(std::make_pair(line, parsed[0]));
+            }
         }
 
-        // Handle Ctrl+C to copy URL
-        if ((event->state & GDK_CONTROL_MASK) && event->keyval == GDK_KEY_c) {
-            on_copy_url_clicked();
-            return true;
+        // A released row whose URL shows up on another line (cut and paste)
+        // is moved there instead of being fetched again
+        std::unordered_map<std::string, std::vector<int>> orphans_by_url;
+        for (int row_id : orphan_rows) {
+            UrlRow* url_row = find_url_row(row_id);
+            if (url_row) {
+                orphans_by_url[url_row->get_url().raw()].push_back(row_id);
+            }
         }
-
-        // Handle Delete key to delete entry
-        if (event->keyval == GDK_KEY_Delete) {
-            on_delete_clicked();
-            return true;
+        orphan_rows.clear();
+
+        std::vector<int> added_rows;
+        for (const auto& new_line : new_lines) {
+            const UrlEntry& entry = new_line.second;
+            auto found = orphans_by_url.find(entry.url.raw());
+            if (found != orphans_by_url.end() && !found->second.empty()) {
+                int row_id = found->second.back();
+                found->second.pop_back();
+                UrlRow* url_row = find_url_row(row_id);
+                Gtk::ListBoxRow* row = dynamic_cast<Gtk::ListBoxRow*>(url_row->get_parent());
+
+                // Hold a reference so removing the row doesn't destroy it
+                row->reference();
+                list_box->remove(*row);
+                list_box->insert(*row, list_position_for_line(new_line.first));
+                row->unreference();
+
+                if (entry.title != entry.url && entry.title != url_row->get_title()) {
+                    url_row->set_title(entry.title);
+                }
+                line_rows[new_line.first] = row_id;
+            } else {
+                UrlRow* url_row = add_url_entry(entry.title, entry.url, list_position_for_line(new_line.first));
+                line_rows[new_line.first] = url_row->get_id();
+                added_rows.push_back(url_row->get_id());
+            }
         }
 
-        // Handle Enter key to open in Chromium
-        if (event->keyval == GDK_KEY_Return || event->keyval == GDK_KEY_KP_Enter) {
-            on_open_chromium_clicked();
-            return true;
+        // Rows whose line is gone
+        for (const auto& orphans : orphans_by_url) {
+            for (int row_id : orphans.second) {
+                UrlRow* url_row = find_url_row(row_id);
+                Gtk::ListBoxRow* row = url_row ? dynamic_cast<Gtk::ListBoxRow*>(url_row->get_parent()) : nullptr;
+                if (row) {
+                    remove_url_row(row);
+                }
+            }
         }
 
-        return false;
+        list_box->show_all();
+        update_url_count();
+        update_row_numbers();
+        schedule_session_save();
+        queue_row_fetches(added_rows);
     }
 
-    void show_context_menu(Gtk::ListBoxRow* row, GdkEventButton* event) {
-        UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
-        if (!url_row) return;
-
-        Gtk::Menu* menu = Gtk::manage(new Gtk::Menu());
-        Gtk::MenuItem* open_item = Gtk::manage(new Gtk::MenuItem("Open URL"));
-        open_item->signal_activate().connect([this, url_row]() {
-            open_url(url_row->get_url());
-        });
-        menu->append(*open_item);
-        menu->show_all();
-        menu->popup(event->button, gdk_event_get_time((GdkEvent*)event));
+    int line_for_row(int row_id) const {
+        auto found = std::find(line_rows.begin(), line_rows.end(), row_id);
+        return found != line_rows.end() ? (int)(found - line_rows.begin()) : -1;
     }
 
-    void open_url(const Glib::ustring& url) {
-        if (url.empty()) return;
-
-        GError* error = nullptr;
-        std::string url_str = url.raw();
-
-        // Ensure URL has a scheme
-        if (url_str.find("://") == std::string::npos) {
-            url_str = "http://" + url_str;
+    void replace_buffer_line(int line, const std::string& text) {
+        Glib::RefPtr<Gtk::TextBuffer> buffer = url_text_view->get_buffer();
+        Gtk::TextBuffer::iterator start = buffer->get_iter_at_line(line);
+        Gtk::TextBuffer::iterator end = start;
+        if (!end.ends_line()) {
+            end.forward_to_line_end();
         }
+        syncing_buffer = true;
+        buffer->insert(buffer->erase(start, end), text);
+        syncing_buffer = false;
+    }
 
-        gchar* uri = g_strdup(url_str.c_str());
+    void sync_row_deleted(int row_id) {
+        if (!live_sync_active()) return;
+        int line = line_for_row(row_id);
+        if (line < 0) return;
 
-        // Use g_app_info_launch_default_for_uri which opens in default browser
-        // Most modern browsers will open this in a new tab if already running
-        if (!g_app_info_launch_default_for_uri(uri, nullptr, &error)) {
-            g_warning("Failed to open URL: %s", error ? error->message : "Unknown error");
-            if (error) {
-                g_error_free(error);
+        Glib::RefPtr<Gtk::TextBuffer> buffer = url_text_view->get_buffer();
+        Gtk::TextBuffer::iterator start = buffer->get_iter_at_line(line);
+        Gtk::TextBuffer::iterator end = start;
+        if (line + 1 < buffer->get_line_count()) {
+            end.forward_line(); // Take the line's newline with it
+        } else {
+            end = buffer->end();
+            if (line > 0) {
+                start.backward_char(); // Last line: take the preceding newline
             }
         }
-
-        g_free(uri);
+        syncing_buffer = true;
+        buffer->erase(start, end);
+        syncing_buffer = false;
+        line_rows.erase(line_rows.begin() + line);
+        if (line_rows.empty()) {
+            line_rows.push_back(-1);
+        }
     }
 
-    void on_load_clicked() {
-        load_urls();
+    // Called after rows were appended to the end of the list
+    void sync_rows_appended(const std::vector<int>& row_ids) {
+        if (!live_sync_active() || row_ids.empty()) return;
+        std::string text;
+        for (int row_id : row_ids) {
+            UrlRow* url_row = find_url_row(row_id);
+            if (!text.empty()) {
+                text += '\n';
+            }
+            text += format_mode2_line(url_row->get_title().raw(), url_row->get_url().raw());
+        }
+
+        // An empty last line takes the first new row; otherwise the new
+        // rows start on a line of their own
+        Glib::RefPtr<Gtk::TextBuffer> buffer = url_text_view->get_buffer();
+        bool last_line_empty = buffer->end().starts_line();
+        if (last_line_empty) {
+            text += '\n';
+            line_rows.pop_back();
+        } else {
+            text.insert(0, "\n");
+        }
+        syncing_buffer = true;
+        buffer->insert(buffer->end(), text);
+        syncing_buffer = false;
+        line_rows.insert(line_rows.end(), row_ids.begin(), row_ids.end());
+        if (last_line_empty) {
+            line_rows.push_back(-1);
+        }
     }
 
-    void on_save_clicked() {
-        save_urls();
+    // Called after two neighbouring rows traded places
+    void sync_rows_swapped(int index_a, int index_b) {
+        if (!live_sync_active()) return;
+        Gtk::ListBoxRow* row_a = list_box->get_row_at_index(index_a);
+        Gtk::ListBoxRow* row_b = list_box->get_row_at_index(index_b);
+        UrlRow* url_row_a = row_a ? dynamic_cast<UrlRow*>(row_a->get_child()) : nullptr;
+        UrlRow* url_row_b = row_b ? dynamic_cast<UrlRow*>(row_b->get_child()) : nullptr;
+        if (!url_row_a || !url_row_b) return;
+
+        int line_a = line_for_row(url_row_a->get_id());
+        int line_b = line_for_row(url_row_b->get_id());
+        if (line_a < 0 || line_b < 0) return;
+
+        // Each row takes over the other's line
+        replace_buffer_line(line_b, format_mode2_line(url_row_a->get_title().raw(), url_row_a->get_url().raw()));
+        replace_buffer_line(line_a, format_mode2_line(url_row_b->get_title().raw(), url_row_b->get_url().raw()));
+        std::swap(line_rows[line_a], line_rows[line_b]);
     }
 
-    void on_refresh_clicked() {
-        download_favicons();
+    // Fetched titles are written back in batches; finding the lines is one
+    // scan over line_rows per batch
+    void queue_line_patch(int row_id) {
+        if (!live_sync_active()) return;
+        pending_line_patches.insert(row_id);
+        if (line_patch_pending) return;
+        line_patch_pending = true;
+
+        Glib::signal_timeout().connect_once(sigc::track_obj([this]() {
+            line_patch_pending = false;
+            std::unordered_set<int> row_ids;
+            row_ids.swap(pending_line_patches);
+            if (!live_sync_active()) return;
+
+            for (size_t line = 0; line < line_rows.size(); ++line) {
+                if (line_rows[line] >= 0 && row_ids.count(line_rows[line])) {
+                    UrlRow* url_row = find_url_row(line_rows[line]);
+                    if (url_row) {
+                        replace_buffer_line(line, format_mode2_line(url_row->get_title().raw(), url_row->get_url().raw()));
+                    }
+                }
+            }
+        }, *this), 300);
     }
 
+    // Fetches rows added while a fetch may already be running
+    void queue_row_fetches(const std::vector<int>& row_ids) {
+        if (row_ids.empty()) return;
+        apply_cached_titles(row_ids);
+        if (!fetch_running) {
+            download_favicons(true);
+            return;
+        }
 
-    void load_urls() {
-        // Get text from text view
-        Glib::RefPtr<Gtk::TextBuffer> buffer = url_text_view->get_buffer();
-        Glib::ustring text = buffer->get_text();
+        for (int row_id : row_ids) {
+            fetch_scheduler.add(row_id);
+        }
+        pending_downloads += row_ids.size();
+        pump_fetches();
+    }
 
-        if (text.empty()) {
-            status_label->set_text("Error: Please paste URLs into the text field");
-            return;
+    // Shows titles known from earlier runs on rows that have none yet.
+    // Expired ones are revalidated when the row's fetch comes up.
+    void apply_cached_titles(const std::vector<int>& row_ids) {
+        if (!metadata_cache) return;
+        PageMetadata cached;
+        std::string url;
+        for (int row_id : row_ids) {
+            UrlRow* url_row = find_url_row(row_id);
+            if (url_row && url_row->get_title() == url_row->get_url() && enrichment_url(url_row, url) &&
+                metadata_cache->lookup(url, cached) && !cached.title.empty()) {
+                set_url_title(row_id, Glib::ustring(cached.title));
+                url_row->set_final_url(cached.final_url);
+            }
         }
+    }
 
-        // Clear existing items
+    bool metadata_expired(const PageMetadata& metadata) const {
+        gint64 age = g_get_real_time() / G_USEC_PER_SEC - metadata.fetched_at;
+        return age < 0 || age > (gint64)settings.title_ttl_hours * 3600;
+    }
+
+    // Starts fetching icons and titles. With only_pending set, rows that
+    // were already fetched (e.g. restored from the session) are skipped.
+    void download_favicons(bool only_pending = false) {
+        finish_restore();
         std::vector<Gtk::Widget*> children = list_box->get_children();
+        std::vector<int> row_ids;
+        row_ids.reserve(children.size());
         for (Gtk::Widget* child : children) {
-            list_box->remove(*child);
+            Gtk::ListBoxRow* row = dynamic_cast<Gtk::ListBoxRow*>(child);
+            UrlRow* url_row = row ? dynamic_cast<UrlRow*>(row->get_child()) : nullptr;
+            if (url_row && (!only_pending || url_row->get_status() == FETCH_PENDING)) {
+                row_ids.push_back(url_row->get_id());
+            }
         }
-        url_entries.clear();
 
-        bool mode2 = mode2_radio->get_active(); // Mode 2: URLs only with # title
-
-        if (mode2) {
-            // Mode 2: URLs only, one per line, optional # title
-            std::istringstream stream(text.raw());
-            std::string line;
+        // Results still in flight from a previous run are ignored, but
+        // their fetches keep counting against the limit until they end
+        fetch_generation++;
+        pending_downloads = row_ids.size();
+        completed_downloads = 0;
 
-            while (std::getline(stream, line)) {
-                // Trim whitespace
-                line.erase(0, line.find_first_not_of(" \t\n\r"));
-                line.erase(line.find_last_not_of(" \t\n\r") + 1);
+        if (pending_downloads == 0) {
+            fetch_scheduler.reset(row_ids);
+            fetch_running = false;
+            progress_bar->set_visible(false);
+            return;
+        }
 
-                if (line.empty()) {
-                    continue;
-                }
+        fetch_scheduler.reset(row_ids);
+        update_visible_rows();
+        if (current_selected_row) {
+            UrlRow* url_row = dynamic_cast<UrlRow*>(current_selected_row->get_child());
+            if (url_row) {
+                fetch_scheduler.set_selected(url_row->get_id());
+            }
+        }
 
-                // Parse line: URL # Title or just URL
-                std::string url_str = line;
-                std::string title_str;
-
-                // Check for # comment
-                size_t hash_pos = line.find(" # ");
-                if (hash_pos != std::string::npos) {
-                    url_str = line.substr(0, hash_pos);
-                    title_str = line.substr(hash_pos + 3); // Skip " # "
-                    // Trim both
-                    url_str.erase(0, url_str.find_first_not_of(" \t"));
-                    url_str.erase(url_str.find_last_not_of(" \t") + 1);
-                    title_str.erase(0, title_str.find_first_not_of(" \t"));
-                    title_str.erase(title_str.find_last_not_of(" \t") + 1);
-                } else {
-                    // No title provided, use URL as title for now
-                    // (Website title will be fetched with favicon)
-                    title_str = url_str;
-                }
+        fetch_running = true;
+        progress_bar->set_visible(true);
+        progress_bar->set_fraction(0.0);
+        status_label->set_text("Downloading favicons...");
 
-                // Convert to Glib::ustring
-                Glib::ustring url, title;
-                try {
-                    url = Glib::ustring(url_str);
-                    title = Glib::ustring(title_str);
-                } catch (...) {
-                    try {
-                        url = Glib::locale_to_utf8(url_str);
-                        title = Glib::locale_to_utf8(title_str);
-                    } catch (...) {
-                        url = url_str;
-                        title = title_str;
-                    }
-                }
+        pump_fetches();
+    }
 
-                url_entries.push_back(UrlEntry(title, url));
-                add_url_entry(title, url);
+    // Starts fetches for the highest-priority rows until the concurrency limit is reached
+    void pump_fetches() {
+        TraceSpan span("fetch-schedule");
+        if (!fetch_running || closing) return;
+
+        int row_id;
+        while (active_fetches < max_concurrent_fetches && fetch_engine.has_capacity() && fetch_scheduler.next(row_id)) {
+            UrlRow* url_row = find_url_row(row_id);
+            if (!url_row) {
+                // Row was deleted while it was queued
+                completed_downloads++;
+                continue;
             }
-        } else {
-            // Mode 1: Title-URL pairs with blank lines
-            std::istringstream stream(text.raw());
-            std::string line;
-            Glib::ustring current_title;
-            bool expecting_url = false;
-
-            while (std::getline(stream, line)) {
-                // Trim whitespace
-                line.erase(0, line.find_first_not_of(" \t\n\r"));
-                line.erase(line.find_last_not_of(" \t\n\r") + 1);
-
-                if (line.empty()) {
-                    expecting_url = false;
-                    continue;
-                }
-
-                // Treat the line as UTF-8
-                Glib::ustring ustring_line;
-                try {
-                    ustring_line = Glib::ustring(line);
-                } catch (...) {
-                    try {
-                        ustring_line = Glib::locale_to_utf8(line);
-                    } catch (...) {
-                        ustring_line = line;
-                    }
-                }
 
-                if (!expecting_url) {
-                    current_title = ustring_line;
-                    expecting_url = true;
-                } else {
-                    url_entries.push_back(UrlEntry(current_title, ustring_line));
-                    add_url_entry(current_title, ustring_line);
-                    expecting_url = false;
-                }
+            if (start_row_fetch(url_row, row_id)) {
+                begin_fetch(row_id);
+            } else {
+                finish_row_fetch(row_id);
+                completed_downloads++;
             }
         }
 
-        status_label->set_text(Glib::ustring::compose("Loaded %1 URLs", url_entries.size()));
-        list_box->show_all();
+        if (active_fetches == 0 && fetch_scheduler.empty()) {
+            // All downloads completed
+            fetch_running = false;
+            progress_bar->set_visible(false);
+            status_label->set_text(Glib::ustring::compose("Loaded %1 URLs", list_box->get_children().size()));
+        }
+    }
 
-        // Update URL count and row numbers
-        update_url_count();
-        update_row_numbers();
+    // Starts a fetch thread for whatever the row still lacks: the target
+    // of its short link, its icon, its title. Returns false when nothing
+    // was missing.
+    bool start_row_fetch(UrlRow* url_row, int row_id) {
+        std::string url;
+        if (!enrichment_url(url_row, url)) {
+            resolve_short_link(url, row_id, fetch_generation);
+            return true;
+        }
 
-        // Start downloading favicons
-        download_favicons();
-    }
+        // Check if title needs to be fetched (title equals URL means no title was provided)
+        bool needs_title = (url_row->get_title() == url_row->get_url());
 
-    void save_urls() {
-        std::vector<Gtk::Widget*> children = list_box->get_children();
-        std::vector<UrlEntry> ordered_entries;
+        // A title (or a page without one) from the cache is only fetched
+        // again once it has expired, as a conditional request
+        PageMetadata cached;
+        if (metadata_cache && metadata_cache->lookup(url, cached)) {
+            bool from_cache = needs_title || url_row->get_title().raw() == cached.title;
+            needs_title = from_cache && metadata_expired(cached);
+        }
 
-        for (Gtk::Widget* child : children) {
-            Gtk::ListBoxRow* row = dynamic_cast<Gtk::ListBoxRow*>(child);
-            if (row) {
-                UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
-                if (url_row) {
-                    ordered_entries.push_back(UrlEntry(url_row->get_title(), url_row->get_url()));
-                }
+        // The icon may already be known: imported with the row, or
+        // brought by another row of the same host
+        bool has_icon = url_row->get_status() != FETCH_PENDING;
+        if (!has_icon) {
+            std::string icon_key = extract_base_url(url);
+            auto cached = icon_cache.find(icon_key);
+            if (cached != icon_cache.end()) {
+                url_row->set_icon(cached->second);
+                url_row->set_icon_key(icon_key);
+                url_row->set_status(FETCH_DONE);
+                has_icon = true;
             }
         }
+        if (has_icon) {
+            if (!needs_title) return false;
+            fetch_page_title(url, row_id, fetch_generation);
+            return true;
+        }
+
+        download_favicon_for_url(url, row_id, fetch_generation, 0, needs_title);
+        return true;
+    }
 
-        // Build the text content - always export in mode 2 format (URL # Title)
-        std::ostringstream text_stream;
-        for (size_t i = 0; i < ordered_entries.size(); ++i) {
-            // Write UTF-8 strings directly (raw() returns UTF-8 bytes)
-            std::string title_utf8 = ordered_entries[i].title.raw();
-            std::string url_utf8 = ordered_entries[i].url.raw();
+    // The URL icons and titles are fetched for: the row's own, or for a
+    // short link the page it leads to. False (with url set to the short
+    // link) when that is not known yet.
+    bool enrichment_url(UrlRow* url_row, std::string& url) {
+        url = url_row->get_url().raw();
+        if (!is_short_link(url)) return true;
 
-            // Format: URL # Title
-            text_stream << url_utf8;
-            if (!title_utf8.empty() && title_utf8 != url_utf8) {
-                text_stream << " # " << title_utf8;
-            }
-            if (i < ordered_entries.size() - 1) {
-                text_stream << "\n";
+        auto expanded = fetch_engine.short_links.find(url);
+        if (expanded != fetch_engine.short_links.end()) {
+            url = expanded->second;
+            return true;
+        }
+        std::string resolved;
+        if (metadata_cache && metadata_cache->lookup_redirect(url, resolved)) {
+            fetch_engine.short_links[url] = resolved;
+            if (url_row->get_final_url().empty()) {
+                url_row->set_final_url(resolved);
             }
+            url = resolved;
+            return true;
         }
+        return false;
+    }
 
-        // Set text in text view
-        Glib::RefPtr<Gtk::TextBuffer> buffer = url_text_view->get_buffer();
-        buffer->set_text(text_stream.str());
-
-        status_label->set_text(Glib::ustring::compose("Exported %1 URLs to text field", ordered_entries.size()));
+    // Follows the redirects of a short link with HEAD requests. The row's
+    // fetch then carries on with the destination (continue_after_resolve).
+    void resolve_short_link(const std::string& url, int row_id, int generation) {
+        std::shared_ptr<MetadataCache> cache = metadata_cache;
+        std::thread([this, cache, url, row_id, generation]() {
+            FetchResult result{FetchResult::RESOLVED, row_id, generation};
+            {
+                TraceSpan span("resolve-link");
+                result.final_url = expand_short_link(url);
+            }
+            if (cache && !result.final_url.empty()) {
+                cache->store_redirect(url, result.final_url);
+            }
+            post_fetch_result(std::move(result));
+        }).detach();
     }
 
-    void add_url_entry(const Glib::ustring& title, const Glib::ustring& url) {
-        UrlRow* row_widget = Gtk::manage(new UrlRow(title, url));
-        Gtk::ListBoxRow* row = Gtk::manage(new Gtk::ListBoxRow());
-        row->add(*row_widget);
-        list_box->append(*row);
+    std::string expand_short_link(const std::string& url) {
+        CURL* curl = curl_easy_init();
+        if (!curl) return std::string();
+
+        fetch_engine.configure(curl);
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+        curl_easy_setopt(curl, CURLOPT_USERAGENT, "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36");
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(curl, CURLOPT_MAXREDIRS, 10L);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+        CURLcode res = curl_easy_perform(curl);
+        long response_code = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+
+        // Some servers refuse HEAD; a GET is cut off at the first body bytes
+        if (res == CURLE_OK && (response_code == 403 || response_code == 405 || response_code == 501)) {
+            curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, discard_body_callback);
+            res = curl_easy_perform(curl);
+            if (res == CURLE_WRITE_ERROR) {
+                res = CURLE_OK;
+            }
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+        }
 
-        // Update URL count and row numbers
-        update_url_count();
-        update_row_numbers();
+        char* effective_url = nullptr;
+        curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &effective_url);
+        std::string resolved = (res == CURLE_OK && response_code < 400 && effective_url) ? effective_url : "";
+        curl_easy_cleanup(curl);
+        return resolved;
     }
 
-    void download_favicons() {
-        std::vector<Gtk::Widget*> children = list_box->get_children();
-        pending_downloads = children.size();
-        completed_downloads = 0;
-        current_download_index = 0;
+    static size_t discard_body_callback(void*, size_t, size_t, void*) {
+        return 0;
+    }
 
-        if (pending_downloads == 0) {
-            return;
+    void continue_after_resolve(const FetchResult& result) {
+        const std::string& resolved = result.final_url;
+        UrlRow* url_row = find_url_row(result.row_id);
+        if (url_row) {
+            // An unreachable short link is enriched as it is
+            fetch_engine.short_links[url_row->get_url().raw()] = resolved.empty() ? url_row->get_url().raw() : resolved;
+            if (!resolved.empty()) {
+                url_row->set_final_url(resolved);
+            }
         }
 
-        progress_bar->set_visible(true);
-        progress_bar->set_fraction(0.0);
-        status_label->set_text("Downloading favicons...");
-
-        // Start downloading the first favicon (sequential)
-        download_next_favicon();
+        // The fetch slot carries over to the destination's fetch
+        bool current = !closing && result.generation == fetch_generation;
+        if (!current || !url_row || !start_row_fetch(url_row, result.row_id)) {
+            update_progress(result.generation, result.row_id);
+        }
     }
 
-    void download_next_favicon() {
-        std::vector<Gtk::Widget*> children = list_box->get_children();
+    // Every fetch started here ends in exactly one update_progress(). The
+    // row's id stays reserved until then, so a result can never land on a
+    // newer row that was given the id of a deleted one.
+    void begin_fetch(int row_id) {
+        entry_store.hold(row_id);
+        active_fetches++;
+        threads_running++;
+        fetch_engine.begin_fetch();
+    }
 
-        if (current_download_index >= (int)children.size()) {
-            // All downloads completed
-            progress_bar->set_visible(false);
-            status_label->set_text(Glib::ustring::compose("Loaded %1 URLs", children.size()));
-            return;
-        }
+    void queue_visible_rows_update() {
+        if (visible_update_pending) return;
+        visible_update_pending = true;
+
+        // Coalesce bursts of scroll events into one update
+        Glib::signal_timeout().connect_once(sigc::track_obj([this]() {
+            visible_update_pending = false;
+            if (!fetch_running) return;
+            update_visible_rows();
+            pump_fetches();
+        }, *this), 50);
+    }
 
-        Gtk::ListBoxRow* row = dynamic_cast<Gtk::ListBoxRow*>(children[current_download_index]);
-        if (row) {
-            UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
-            if (url_row) {
-                // Check if title needs to be fetched (title equals URL means no title was provided)
-                bool needs_title = (url_row->get_title() == url_row->get_url());
-                download_favicon_for_url(url_row->get_url(), current_download_index, 0, needs_title);
-            } else {
-                // Skip this row and move to next
-                current_download_index++;
-                download_next_favicon();
+    // Hands the rows inside the viewport (plus half a page below it) to the scheduler
+    void update_visible_rows() {
+        TraceSpan span("visible-rows");
+        std::vector<int> visible_ids;
+        Glib::RefPtr<Gtk::Adjustment> vadjustment = scrolled_window->get_vadjustment();
+        int top = (int)vadjustment->get_value();
+        int bottom = (int)(vadjustment->get_value() + vadjustment->get_page_size() * 1.5);
+
+        Gtk::ListBoxRow* first_row = list_box->get_row_at_y(top);
+        if (first_row) {
+            for (int i = first_row->get_index(); ; ++i) {
+                Gtk::ListBoxRow* row = list_box->get_row_at_index(i);
+                if (!row || row->get_allocation().get_y() > bottom) break;
+                UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
+                if (url_row) {
+                    visible_ids.push_back(url_row->get_id());
+                }
             }
-        } else {
-            // Skip this widget and move to next
-            current_download_index++;
-            download_next_favicon();
         }
+
+        fetch_scheduler.set_visible(visible_ids);
+    }
+
+    UrlRow* find_url_row(int row_id) {
+        auto it = rows_by_id.find(row_id);
+        return it != rows_by_id.end() ? it->second : nullptr;
     }
 
-    void download_favicon_for_url(const Glib::ustring& url_string, int item_index, int attempt, bool fetch_title = false) {
-        std::thread([this, url_string, item_index, attempt, fetch_title]() {
+    void download_favicon_for_url(const Glib::ustring& url_string, int row_id, int generation, int attempt, bool fetch_title = false) {
+        std::thread([this, url_string, row_id, generation, attempt, fetch_title]() {
             std::string url = url_string.raw();
             std::string base_url = extract_base_url(url);
             std::string favicon_url;
@@ -896,97 +6122,76 @@ private:
                 case 2:
                     {
                         std::string host = extract_host(url);
-                        favicon_url = "https://www.google.com/s2/favicons?domain=" + host + "&sz=32";
+                        favicon_url = favicon_service + host + "&sz=32";
                     }
                     break;
                 default:
-                    Glib::signal_idle().connect_once([this]() { update_progress(); });
+                    post_fetch_result(FetchResult{FetchResult::DONE, row_id, generation});
                     return;
             }
 
             CURL* curl = curl_easy_init();
             if (!curl) {
-                Glib::signal_idle().connect_once([this]() { update_progress(); });
+                post_fetch_result(FetchResult{FetchResult::DONE, row_id, generation});
                 return;
             }
 
-            std::string response_data;
+            // The icon is decoded as it arrives; non-images and oversized
+            // bodies abort the transfer early
+            guint64 max_icon_bytes = settings.max_icon_bytes;
+            IconStreamDecoder decoder(curl, max_icon_bytes);
 
+            fetch_engine.configure(curl);
             curl_easy_setopt(curl, CURLOPT_URL, favicon_url.c_str());
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_data);
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, IconStreamDecoder::on_curl_write);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &decoder);
+            curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, IconStreamDecoder::on_curl_header);
+            curl_easy_setopt(curl, CURLOPT_HEADERDATA, &decoder);
+            curl_easy_setopt(curl, CURLOPT_MAXFILESIZE_LARGE, (curl_off_t)max_icon_bytes);
             curl_easy_setopt(curl, CURLOPT_USERAGENT, "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36");
             curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
             curl_easy_setopt(curl, CURLOPT_TIMEOUT, 5L);
 
-            CURLcode res = curl_easy_perform(curl);
-            long response_code = 0;
-            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-            curl_easy_cleanup(curl);
+            CURLcode res;
+            {
+                TraceSpan span("fetch-icon");
+                res = curl_easy_perform(curl);
+            }
 
             bool success = false;
-            if (res == CURLE_OK && response_code == 200 && !response_data.empty()) {
-                // Use C API to load pixbuf from data
-                GError* error = nullptr;
-                GdkPixbufLoader* loader = gdk_pixbuf_loader_new();
-
-                if (loader) {
-                    gboolean write_ok = gdk_pixbuf_loader_write(loader,
-                        (const guint8*)response_data.data(),
-                        response_data.size(), &error);
-
-                    if (write_ok && !error) {
-                        gboolean close_ok = gdk_pixbuf_loader_close(loader, &error);
-
-                        if (close_ok && !error) {
-                            GdkPixbuf* pixbuf_c = gdk_pixbuf_loader_get_pixbuf(loader);
-
-                            if (pixbuf_c) {
-                                // The loader owns the pixbuf, so we need to ref it to keep it alive
-                                g_object_ref(pixbuf_c);
-                                // Wrap it in a RefPtr - wrap() will manage the ref
-                                Glib::RefPtr<Gdk::Pixbuf> pixbuf = Glib::wrap(pixbuf_c);
-
-                                if (pixbuf) {
-                                    Glib::signal_idle().connect_once([this, pixbuf, item_index]() {
-                                        set_favicon(item_index, pixbuf);
-                                    });
-                                    success = true;
-                                }
-                            }
-                        }
-                    }
-
-                    if (error) {
-                        g_error_free(error);
-                    }
-
-                    g_object_unref(loader);
+            if (res == CURLE_OK) {
+                TraceSpan span("decode");
+                Glib::RefPtr<Gdk::Pixbuf> pixbuf = decoder.finish();
+                if (pixbuf) {
+                    post_fetch_result(FetchResult{FetchResult::ICON, row_id, generation, pixbuf, base_url});
+                    success = true;
                 }
             }
+            curl_easy_cleanup(curl);
 
             if (!success && attempt < 2) {
-                download_favicon_for_url(url_string, item_index, attempt + 1, fetch_title);
-            } else if (!success) {
-                // Create fallback icon
-                Glib::RefPtr<Gdk::Pixbuf> fallback = Gdk::Pixbuf::create(Gdk::COLORSPACE_RGB, true, 8, 32, 32);
-                fallback->fill(0x80808080); // Gray with alpha
-                Glib::signal_idle().connect_once([this, fallback, item_index]() {
-                    set_favicon(item_index, fallback);
-                });
+                // Try the next favicon location; that attempt reports progress
+                download_favicon_for_url(url_string, row_id, generation, attempt + 1, fetch_title);
+                return;
+            }
+
+            if (!success) {
+                // No icon anywhere, show the fallback icon
+                post_fetch_result(FetchResult{FetchResult::ICON, row_id, generation});
             }
 
             // If we need to fetch the title, do it now (after favicon is done)
             if (fetch_title) {
-                fetch_page_title(url_string, item_index);
+                fetch_page_title(url_string, row_id, generation);
             } else {
-                Glib::signal_idle().connect_once([this]() { update_progress(); });
+                post_fetch_result(FetchResult{FetchResult::DONE, row_id, generation});
             }
         }).detach();
     }
 
-    void fetch_page_title(const Glib::ustring& url_string, int item_index) {
-        std::thread([this, url_string, item_index]() {
+    void fetch_page_title(const Glib::ustring& url_string, int row_id, int generation) {
+        std::shared_ptr<MetadataCache> cache = metadata_cache;
+        std::thread([this, cache, url_string, row_id, generation]() {
             std::string url = url_string.raw();
 
             // Ensure URL has a scheme
@@ -996,26 +6201,66 @@ private:
 
             CURL* curl = curl_easy_init();
             if (!curl) {
-                Glib::signal_idle().connect_once([this]() { update_progress(); });
+                post_fetch_result(FetchResult{FetchResult::DONE, row_id, generation});
                 return;
             }
 
             std::string html_data;
+            PageMetadata metadata;
+
+            // Revalidate a cached entry instead of downloading the page again
+            PageMetadata cached;
+            bool have_cached = cache && cache->lookup(url, cached);
+            struct curl_slist* request_headers = nullptr;
+            if (have_cached && !cached.etag.empty()) {
+                request_headers = curl_slist_append(request_headers, ("If-None-Match: " + cached.etag).c_str());
+            }
+            if (have_cached && !cached.last_modified.empty()) {
+                request_headers = curl_slist_append(request_headers, ("If-Modified-Since: " + cached.last_modified).c_str());
+            }
 
+            fetch_engine.configure(curl);
             curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
             curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
             curl_easy_setopt(curl, CURLOPT_WRITEDATA, &html_data);
+            curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, validator_header_callback);
+            curl_easy_setopt(curl, CURLOPT_HEADERDATA, &metadata);
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, request_headers);
             curl_easy_setopt(curl, CURLOPT_USERAGENT, "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36");
             curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
             curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
 
-            CURLcode res = curl_easy_perform(curl);
+            CURLcode res;
+            {
+                TraceSpan span("fetch-title");
+                res = curl_easy_perform(curl);
+            }
             long response_code = 0;
             curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+            // Where the redirects ended up, kept for exports with metadata
+            char* effective_url = nullptr;
+            curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &effective_url);
+            std::string final_url = (res == CURLE_OK && effective_url) ? effective_url : "";
+            char* content_type = nullptr;
+            curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &content_type);
+            metadata.content_type = (res == CURLE_OK && content_type) ? content_type : "";
             curl_easy_cleanup(curl);
+            curl_slist_free_all(request_headers);
+
+            if (res == CURLE_OK && response_code == 304 && have_cached) {
+                // Unchanged since the cached fetch
+                cached.fetched_at = g_get_real_time() / G_USEC_PER_SEC;
+                cache->store(url, cached);
+                FetchResult result{FetchResult::TITLE, row_id, generation};
+                result.title = cached.title;
+                result.final_url = cached.final_url;
+                post_fetch_result(std::move(result));
+                return;
+            }
 
             std::string title;
             if (res == CURLE_OK && response_code == 200 && !html_data.empty()) {
+                TraceSpan span("decode");
                 // Extract title from HTML
                 size_t title_start = html_data.find("<title>");
                 if (title_start != std::string::npos) {
@@ -1028,66 +6273,251 @@ private:
                         title.erase(title.find_last_not_of(" \t\n\r") + 1);
                     }
                 }
-            }
-
-            // Update title in UI (even if empty, to trigger progress update)
-            Glib::ustring title_ustring;
-            if (!title.empty()) {
-                try {
-                    title_ustring = Glib::ustring(title);
-                } catch (...) {
-                    try {
-                        title_ustring = Glib::locale_to_utf8(title);
-                    } catch (...) {
-                        title_ustring = title;
+                if (!title.empty()) {
+                    // The header's charset wins over the page's own, and
+                    // undeclared pages that aren't UTF-8 are windows-1252
+                    std::string charset = TextDecoder::charset_from_content_type(metadata.content_type);
+                    if (charset.empty()) {
+                        charset = TextDecoder::charset_from_html(html_data);
                     }
+                    title = TextDecoder::to_utf8(title, charset, "windows-1252");
                 }
-            } else {
-                // If we couldn't get the title, keep the URL as title
-                title_ustring = url_string;
             }
 
-            Glib::signal_idle().connect_once([this, title_ustring, item_index]() {
-                set_url_title(item_index, title_ustring);
-                update_progress();
-            });
+            // Remember every answer the server gave, including pages without
+            // a title; network errors are retried next time
+            if (cache && res == CURLE_OK) {
+                metadata.title = title;
+                metadata.final_url = final_url;
+                metadata.http_status = response_code;
+                metadata.fetched_at = g_get_real_time() / G_USEC_PER_SEC;
+                cache->store(url, metadata);
+            }
+
+            // Sent even when empty, to finish the row
+            FetchResult result{FetchResult::TITLE, row_id, generation};
+            result.title = title;
+            result.final_url = final_url;
+            post_fetch_result(std::move(result));
         }).detach();
     }
 
-    void set_url_title(int item_index, const Glib::ustring& title) {
-        std::vector<Gtk::Widget*> children = list_box->get_children();
-        if (item_index >= 0 && item_index < (int)children.size()) {
-            Gtk::ListBoxRow* row = dynamic_cast<Gtk::ListBoxRow*>(children[item_index]);
-            if (row) {
-                UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
-                if (url_row) {
-                    url_row->set_title(title);
-                }
+    void set_url_title(int row_id, const Glib::ustring& title) {
+        TraceSpan span("ui-apply");
+        UrlRow* url_row = find_url_row(row_id);
+        if (url_row) {
+            url_row->set_title(title);
+            queue_line_patch(row_id);
+        }
+    }
+
+    // A null pixbuf means no favicon was found for the row
+    void set_favicon(int row_id, Glib::RefPtr<Gdk::Pixbuf> pixbuf, const std::string& icon_key) {
+        TraceSpan span("ui-apply");
+        UrlRow* url_row = find_url_row(row_id);
+        if (!pixbuf) {
+            if (url_row) {
+                url_row->set_icon(fallback_icon);
+                url_row->set_status(FETCH_FAILED);
             }
+            return;
+        }
+
+        // Keep the scaled icon so other rows of the same host can reuse it
+        Glib::RefPtr<Gdk::Pixbuf> icon = pixbuf->scale_simple(32, 32, Gdk::INTERP_BILINEAR);
+        icon_cache[icon_key] = icon;
+        saved_icon_keys.erase(icon_key);
+        if (url_row) {
+            url_row->set_icon(icon);
+            url_row->set_icon_key(icon_key);
+            url_row->set_status(FETCH_DONE);
         }
     }
 
-    void set_favicon(int item_index, Glib::RefPtr<Gdk::Pixbuf> pixbuf) {
-        std::vector<Gtk::Widget*> children = list_box->get_children();
-        if (item_index >= 0 && item_index < (int)children.size()) {
-            Gtk::ListBoxRow* row = dynamic_cast<Gtk::ListBoxRow*>(children[item_index]);
-            if (row) {
-                UrlRow* url_row = dynamic_cast<UrlRow*>(row->get_child());
-                if (url_row) {
-                    url_row->set_icon(pixbuf);
-                }
+    void finish_row_fetch(int row_id) {
+        UrlRow* url_row = find_url_row(row_id);
+        if (url_row) {
+            url_row->set_fetched_at(g_get_real_time() / G_USEC_PER_SEC);
+        }
+        schedule_row_save(row_id);
+    }
+
+    void update_progress(int generation, int row_id) {
+        TraceSpan span("ui-apply");
+        entry_store.release(row_id);
+        threads_running--;
+        fetch_engine.end_fetch();
+        if (closing) {
+            delete_if_finished();
+            return;
+        }
+        finish_row_fetch(row_id);
+        active_fetches--;
+        if (generation == fetch_generation) {
+            completed_downloads++;
+            double fraction = (double)completed_downloads / pending_downloads;
+            progress_bar->set_fraction(std::min(fraction, 1.0));
+        }
+
+        // Start the next fetches in priority order. A drain of queued
+        // results does this once at the end instead.
+        if (!draining_results) {
+            pump_fetches();
+        }
+    }
+
+    // Called on fetch threads. Results are queued rather than posted as
+    // one idle callback each. Once the result is queued the window may be
+    // gone, so only the thread's own reference to the channel is used.
+    void post_fetch_result(FetchResult&& result) {
+        std::shared_ptr<FetchResultChannel> channel = fetch_results;
+        channel->post(std::move(result));
+    }
+
+    // Results are applied from the frame clock, so everything that arrived
+    // since the last frame is drawn in one redraw. Without frames (window
+    // not mapped) an idle handler drains instead.
+    void start_results_drain() {
+        if (get_mapped()) {
+            last_results_tick_us = g_get_monotonic_time();
+            results_tick_id = gtk_widget_add_tick_callback(GTK_WIDGET(gobj()), &UrlEditorWindow::on_results_tick,
+                                                           this, nullptr);
+            // A mapped window may still get no frames (minimized on
+            // Wayland, a stalled frame clock); a slow timeout takes over then
+            Glib::signal_timeout().connect(sigc::mem_fun(*this, &UrlEditorWindow::on_results_timeout),
+                                           results_timeout_ms, Glib::PRIORITY_LOW);
+        } else {
+            Glib::signal_idle().connect(sigc::mem_fun(*this, &UrlEditorWindow::drain_fetch_results));
+        }
+    }
+
+    static gboolean on_results_tick(GtkWidget*, GdkFrameClock*, gpointer data) {
+        UrlEditorWindow* self = (UrlEditorWindow*)data;
+        self->last_results_tick_us = g_get_monotonic_time();
+        if (self->drain_fetch_results()) return G_SOURCE_CONTINUE;
+        self->results_tick_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    bool on_results_timeout() {
+        if (!results_tick_id) return false; // The frame clock finished the burst
+        if (g_get_monotonic_time() - last_results_tick_us < results_timeout_ms * 1000) return true;
+        if (drain_fetch_results()) return true;
+        gtk_widget_remove_tick_callback(GTK_WIDGET(gobj()), results_tick_id);
+        results_tick_id = 0;
+        return false;
+    }
+
+    // Applies queued results until the queue is empty or the frame budget
+    // is spent. Returns true while results remain.
+    bool drain_fetch_results() {
+        TraceSpan span("ui-apply-batch");
+        gint64 deadline = g_get_monotonic_time() + result_budget_us;
+        long applied = 0;
+        FetchResult result;
+
+        draining_results = true;
+        while (fetch_results->results.pop(result)) {
+            apply_fetch_result(result);
+            applied++;
+            if (g_get_monotonic_time() >= deadline) break;
+        }
+        draining_results = false;
+        span.set_count(applied);
+
+        if (fetch_running) {
+            pump_fetches();
+        }
+        if (!fetch_results->results.empty()) return true;
+
+        // A result pushed between the last pop and clearing the flag would
+        // otherwise wait for the next burst
+        fetch_results->drain_scheduled = false;
+        return !fetch_results->results.empty() && !fetch_results->drain_scheduled.exchange(true);
+    }
+
+    void apply_fetch_result(FetchResult& result) {
+        switch (result.kind) {
+        case FetchResult::RESOLVED:
+            continue_after_resolve(result);
+            break;
+        case FetchResult::ICON:
+            set_favicon(result.row_id, result.pixbuf, result.icon_key);
+            break;
+        case FetchResult::TITLE: {
+            UrlRow* url_row = find_url_row(result.row_id);
+            if (url_row) {
+                // Without a title the row keeps showing its URL
+                set_url_title(result.row_id, result.title.empty() ? url_row->get_url() : Glib::ustring(result.title));
+                url_row->set_final_url(result.final_url);
+            }
+            update_progress(result.generation, result.row_id);
+            break;
+        }
+        case FetchResult::DONE:
+            update_progress(result.generation, result.row_id);
+            break;
+        }
+    }
+
+    static Glib::RefPtr<Gdk::Pixbuf> pixbuf_from_data(const guint8* data, size_t size) {
+        Glib::RefPtr<Gdk::Pixbuf> pixbuf;
+        GError* error = nullptr;
+        GdkPixbufLoader* loader = gdk_pixbuf_loader_new();
+        if (!loader) return pixbuf;
+
+        gboolean ok = gdk_pixbuf_loader_write(loader, data, size, &error);
+        // Closing is required even after a failed write
+        ok = gdk_pixbuf_loader_close(loader, ok ? &error : nullptr) && ok;
+        if (ok) {
+            GdkPixbuf* pixbuf_c = gdk_pixbuf_loader_get_pixbuf(loader);
+            if (pixbuf_c) {
+                // The loader owns the pixbuf, so take our own reference
+                pixbuf = Glib::wrap(pixbuf_c, true);
             }
         }
+
+        if (error) {
+            g_error_free(error);
+        }
+        g_object_unref(loader);
+        return pixbuf;
     }
 
-    void update_progress() {
-        completed_downloads++;
-        double fraction = (double)completed_downloads / pending_downloads;
-        progress_bar->set_fraction(fraction);
+    static bool pixbuf_to_png(const Glib::RefPtr<Gdk::Pixbuf>& pixbuf, std::string& png) {
+        gchar* buffer = nullptr;
+        gsize buffer_size = 0;
+        try {
+            pixbuf->save_to_buffer(buffer, buffer_size, "png");
+        } catch (...) {
+            return false;
+        }
+        png.assign(buffer, buffer_size);
+        g_free(buffer);
+        return true;
+    }
 
-        // Move to next favicon (sequential download)
-        current_download_index++;
-        download_next_favicon();
+    // Collects ETag and Last-Modified of the final response into a PageMetadata
+    static size_t validator_header_callback(char* buffer, size_t size, size_t nitems, void* userp) {
+        PageMetadata* metadata = (PageMetadata*)userp;
+        size_t length = size * nitems;
+        std::string line(buffer, length);
+        line.erase(line.find_last_not_of(" \t\r\n") + 1);
+
+        auto value_after = [&line](size_t name_length) {
+            size_t start = line.find_first_not_of(" \t", name_length);
+            return start == std::string::npos ? std::string() : line.substr(start);
+        };
+        if (g_ascii_strncasecmp(line.c_str(), "HTTP/", 5) == 0) {
+            // A new response (after a redirect) starts
+            metadata->etag.clear();
+            metadata->last_modified.clear();
+        } else if (g_ascii_strncasecmp(line.c_str(), "etag:", 5) == 0) {
+            metadata->etag = value_after(5);
+        } else if (g_ascii_strncasecmp(line.c_str(), "last-modified:", 14) == 0) {
+            metadata->last_modified = value_after(14);
+        }
+        return length;
     }
 
     static size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
@@ -1096,7 +6526,7 @@ private:
     }
 
     std::string extract_base_url(const std::string& url_string) {
-        std::regex url_regex(R"(^(([^:/?#]+):)?(//([^/?#]*))?([^?#]*)(\?([^#]*))?(#(.*))?)");
+        static const std::regex url_regex(R"(^(([^:/?#]+):)?(//([^/?#]*))?([^?#]*)(\?([^#]*))?(#(.*))?)");
         std::smatch match;
 
         if (std::regex_match(url_string, match, url_regex)) {
@@ -1112,7 +6542,7 @@ private:
     }
 
     std::string extract_host(const std::string& url_string) {
-        std::regex url_regex(R"(^(([^:/?#]+):)?(//([^/?#]*))?([^?#]*)(\?([^#]*))?(#(.*))?)");
+        static const std::regex url_regex(R"(^(([^:/?#]+):)?(//([^/?#]*))?([^?#]*)(\?([^#]*))?(#(.*))?)");
         std::smatch match;
 
         if (std::regex_match(url_string, match, url_regex)) {
@@ -1122,10 +6552,41 @@ private:
         return "";
     }
 
+    struct StatsColumns : public Gtk::TreeModel::ColumnRecord {
+        StatsColumns() {
+            add(key);
+            add(name);
+            add(total);
+            add(failed);
+            add(untitled);
+        }
+        Gtk::TreeModelColumn<uint32_t> key;
+        Gtk::TreeModelColumn<Glib::ustring> name;
+        Gtk::TreeModelColumn<uint32_t> total;
+        Gtk::TreeModelColumn<uint32_t> failed;
+        Gtk::TreeModelColumn<uint32_t> untitled;
+    };
+
+    struct SimilarColumns : public Gtk::TreeModel::ColumnRecord {
+        SimilarColumns() {
+            add(is_entry);
+            add(keep);
+            add(row_id);
+            add(title);
+            add(url);
+        }
+        Gtk::TreeModelColumn<bool> is_entry; // false for group headers
+        Gtk::TreeModelColumn<bool> keep;
+        Gtk::TreeModelColumn<int> row_id;
+        Gtk::TreeModelColumn<Glib::ustring> title;
+        Gtk::TreeModelColumn<Glib::ustring> url;
+    };
+
     Gtk::Box* main_box;
     Gtk::Box* header_box;
     Gtk::RadioButton* mode1_radio;
     Gtk::RadioButton* mode2_radio;
+    Gtk::CheckButton* live_sync_check;
     Gtk::TextView* url_text_view;
     Gtk::ScrolledWindow* url_text_scrolled;
     Gtk::Label* url_count_label;
@@ -1133,28 +6594,138 @@ private:
     Gtk::ListBox* list_box;
     Gtk::Box* button_box;
     Gtk::Button* load_button;
+    Gtk::Button* import_button;
+    Gtk::Button* watch_button;
     Gtk::Button* save_button;
+    Gtk::Button* export_file_button;
     Gtk::Button* refresh_button;
+    Gtk::Button* find_similar_button;
     Gtk::Button* move_up_button;
     Gtk::Button* move_down_button;
     Gtk::Button* delete_button;
     Gtk::Button* copy_url_button;
-    Gtk::Button* open_chromium_button;
+    Gtk::Button* open_browser_button;
+    Gtk::Button* archive_button;
     Gtk::Box* status_box;
     Gtk::Label* status_label;
     Gtk::ProgressBar* progress_bar;
-
-    std::vector<UrlEntry> url_entries;
+    Gtk::CheckButton* stats_check;
+    Gtk::Box* stats_panel;
+    Gtk::ComboBoxText* stats_group_combo;
+    Gtk::Label* stats_summary_label;
+    Gtk::TreeView* stats_view;
+    Gtk::Button* stats_show_all_button;
+    StatsColumns stats_columns;
+    SimilarColumns similar_columns;
+    Glib::RefPtr<Gtk::ListStore> stats_model;
+    sigc::connection stats_refresh_connection;
+    uint64_t stats_change_count = 0;
+    bool updating_stats = false;
+    bool stats_filter_active = false;
+    EntryStore::StatsGroup stats_filter_group = EntryStore::GROUP_DOMAIN;
+    uint32_t stats_filter_key = 0;
+
+    AppSettings settings;
+    EntryStore entry_store;
+    std::unordered_map<int, UrlRow*> rows_by_id;
+    FetchScheduler fetch_scheduler;
+    int fetch_generation = 0;
+    bool fetch_running = false;
+    bool visible_update_pending = false;
+    int active_fetches = 0;
+    int max_concurrent_fetches = 4;
+    int threads_running = 0; // fetch, import and analysis threads that still use this window
+    bool closing = false;
+    bool delete_pending = false;
     int pending_downloads = 0;
     std::atomic<int> completed_downloads{0};
-    int current_download_index = 0;
+    std::shared_ptr<FetchResultChannel> fetch_results = std::make_shared<FetchResultChannel>();
+    bool draining_results = false;
+    const gint64 result_budget_us = 4000; // Per frame
+    const unsigned int results_timeout_ms = 100; // Drain without frames after this long
+    guint results_tick_id = 0;
+    gint64 last_results_tick_us = 0;
     Gtk::ListBoxRow* current_selected_row = nullptr;
+    std::deque<std::string> browser_queue;
+    size_t browser_queue_total = 0;
+    bool browser_launch_pending = false;
+
+    Glib::RefPtr<Gdk::Pixbuf> fallback_icon;
+    std::string favicon_service = "https://www.google.com/s2/favicons?domain=";
+    FetchEngine& fetch_engine = FetchEngine::instance();
+    std::unordered_map<std::string, Glib::RefPtr<Gdk::Pixbuf>>& icon_cache = fetch_engine.icons;
+    std::shared_ptr<SessionStore> session_store;
+    std::shared_ptr<MetadataCache> metadata_cache;
+    std::shared_ptr<PageArchive> page_archive;
+    std::unique_ptr<PageArchiver> page_archiver;
+    sigc::connection archive_progress_connection;
+    std::unordered_set<std::string> saved_icon_keys;
+    long session_sequence = 0;
+    bool session_save_pending = false;
+    bool session_structure_dirty = false;  // rows added, removed or moved since the last full save
+    std::unordered_set<int> session_dirty_rows;
+    bool restoring_session = false;
+    std::vector<SessionEntry> restore_entries;                 // saved rows not all built yet
+    std::unordered_map<std::string, std::string> restore_icons; // saved PNGs not decoded yet
+    size_t restore_next = 0;
+    sigc::connection restore_connection;
+    const size_t restore_first_rows = 200;  // Built before the window is shown
+    const gint64 restore_budget_us = 8000;  // Per idle batch
+
+    std::vector<int> line_rows{-1}; // row id per text buffer line, -1 for none
+    bool line_map_valid = false;
+    bool syncing_buffer = false;
+    bool live_sync_pending = false;
+    int dirty_first = -1;
+    int dirty_last = -1;
+    std::unordered_set<int> orphan_rows;
+    std::unordered_set<int> pending_line_patches;
+    bool line_patch_pending = false;
+
+    std::vector<UrlEntry> submitted_entries;
+    int submission_count = 0;
+    bool submission_flush_pending = false;
+
+    Glib::RefPtr<Gio::FileMonitor> watch_monitor;
+    std::unique_ptr<FileTailer> file_tailer;
+    bool watch_read_pending = false;
 };
 
+// The benchmark suite includes this file and brings its own main()
+#ifndef URL_EDITOR_NO_MAIN
 int main(int argc, char* argv[]) {
-    auto app = Gtk::Application::create(argc, argv, "com.stelijah.url-editor");
-
-    UrlEditorWindow window;
-
-    return app->run(window);
+    // Tracing: --trace=<file> or URL_EDITOR_TRACE=<file>. The flag is taken
+    // out before GTK sees the command line.
+    Tracer::instance().start_from_environment();
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--trace=", 8) == 0) {
+            Tracer::instance().start(argv[i] + 8);
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    argv[argc] = nullptr;
+
+    // One instance per session: starting the program again sends its
+    // command line (URLs to add, "-" for stdin) to the running one
+    auto app = Gtk::Application::create(argc, argv, "com.stelijah.url-editor", Gio::APPLICATION_HANDLES_COMMAND_LINE);
+
+    std::unique_ptr<UrlEditorWindow> window;
+    app->signal_command_line().connect([&app, &window](const Glib::RefPtr<Gio::ApplicationCommandLine>& command_line) {
+        if (!window) {
+            window.reset(new UrlEditorWindow());
+            app->add_window(*window);
+            window->present();
+        }
+        window->submit_command_line(command_line);
+        return 0;
+    }, false);
+
+    int status = app->run();
+    window.reset();
+    Tracer::instance().stop();
+    return status;
 }
+#endif